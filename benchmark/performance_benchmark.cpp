@@ -12,8 +12,11 @@
 #include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <random>
 #include <string>
+#include <sys/eventfd.h>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
 using namespace std::chrono;
@@ -568,6 +571,66 @@ benchmark_result benchmark_http_parser_fragmented() {
     return result;
 }
 
+// 512 level-triggered eventfds that stay readable, so every wait returns a full batch. Each
+// callback updates its own connection-sized object, allocated in shuffled order.
+benchmark_result benchmark_reactor_dispatch(bool prefetch_hints) {
+    constexpr size_t fd_count = 512;
+    constexpr uint64_t target_events = 2'000'000;
+
+    struct alignas(64) fake_connection {
+        uint64_t events = 0;
+        char state[248] = {};
+    };
+
+    reactor r(static_cast<int32_t>(fd_count));
+    std::vector<std::unique_ptr<fake_connection>> connections(fd_count);
+    for (auto& conn : connections) {
+        conn = std::make_unique<fake_connection>();
+    }
+    std::shuffle(connections.begin(), connections.end(), std::mt19937{42});
+
+    std::vector<int32_t> fds;
+    uint64_t total = 0;
+    for (size_t i = 0; i < fd_count; ++i) {
+        int32_t fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        fds.push_back(fd);
+        auto* conn = connections[i].get();
+        (void)r.register_fd(fd, event_type::readable, [conn, &total, &r](event_type) {
+            conn->events++;
+            conn->state[conn->events % sizeof(conn->state)]++;
+            if (++total == target_events) {
+                r.stop();
+            }
+        });
+        if (prefetch_hints) {
+            r.set_fd_prefetch_hint(fd, conn);
+        }
+    }
+
+    auto start = steady_clock::now();
+    (void)r.run();
+    auto end = steady_clock::now();
+    auto duration_ms = static_cast<uint64_t>(duration_cast<milliseconds>(end - start).count());
+
+    for (int32_t fd : fds) {
+        (void)r.unregister_fd(fd);
+        close(fd);
+    }
+
+    benchmark_result result;
+    result.name = prefetch_hints ? "Reactor Dispatch (512 fds, prefetch)"
+                                 : "Reactor Dispatch (512 fds)";
+    result.operations = total;
+    result.duration_ms = duration_ms;
+    result.throughput = (static_cast<double>(total) * 1000.0) /
+                        static_cast<double>(std::max<uint64_t>(1, duration_ms));
+    result.latency_p50 = 0.0;
+    result.latency_p99 = 0.0;
+    result.latency_p999 = 0.0;
+
+    return result;
+}
+
 int main() {
     std::cout << "========================================\n";
     std::cout << "   KATANA Performance Benchmarks\n";
@@ -575,46 +638,54 @@ int main() {
 
     std::vector<benchmark_result> results;
 
-    std::cout << "\n[1/10] Benchmarking ring_buffer_queue (single thread)...\n";
+    std::cout << "\n[1/12] Benchmarking ring_buffer_queue (single thread)...\n";
     results.push_back(benchmark_ring_buffer_queue());
     print_result(results.back());
 
-    std::cout << "\n[2/10] Benchmarking ring_buffer_queue (concurrent)...\n";
+    std::cout << "\n[2/12] Benchmarking ring_buffer_queue (concurrent)...\n";
     results.push_back(benchmark_ring_buffer_concurrent());
     print_result(results.back());
 
-    std::cout << "\n[3/10] Benchmarking ring_buffer_queue (high contention)...\n";
+    std::cout << "\n[3/12] Benchmarking ring_buffer_queue (high contention)...\n";
     results.push_back(benchmark_ring_buffer_high_contention());
     print_result(results.back());
 
-    std::cout << "\n[4/10] Benchmarking circular_buffer...\n";
+    std::cout << "\n[4/12] Benchmarking circular_buffer...\n";
     results.push_back(benchmark_circular_buffer());
     print_result(results.back());
 
-    std::cout << "\n[5/10] Benchmarking SIMD CRLF search (1.5KB)...\n";
+    std::cout << "\n[5/12] Benchmarking SIMD CRLF search (1.5KB)...\n";
     results.push_back(benchmark_simd_crlf_search());
     print_result(results.back());
 
-    std::cout << "\n[6/10] Benchmarking SIMD CRLF search (16KB)...\n";
+    std::cout << "\n[6/12] Benchmarking SIMD CRLF search (16KB)...\n";
     results.push_back(benchmark_simd_crlf_large_buffer());
     print_result(results.back());
 
-    std::cout << "\n[7/10] Benchmarking HTTP parser (full message)...\n";
+    std::cout << "\n[7/12] Benchmarking HTTP parser (full message)...\n";
     results.push_back(benchmark_http_parser());
     print_result(results.back());
 
-    std::cout << "\n[8/10] Benchmarking HTTP parser (fragmented)...\n";
+    std::cout << "\n[8/12] Benchmarking HTTP parser (fragmented)...\n";
     results.push_back(benchmark_http_parser_fragmented());
     print_result(results.back());
 
-    std::cout << "\n[9/10] Benchmarking arena allocations...\n";
+    std::cout << "\n[9/12] Benchmarking arena allocations...\n";
     results.push_back(benchmark_arena_small_allocs());
     print_result(results.back());
 
-    std::cout << "\n[10/10] Benchmarking memory allocations...\n";
+    std::cout << "\n[10/12] Benchmarking memory allocations...\n";
     results.push_back(benchmark_memory_allocations());
     print_result(results.back());
 
+    std::cout << "\n[11/12] Benchmarking reactor dispatch...\n";
+    results.push_back(benchmark_reactor_dispatch(false));
+    print_result(results.back());
+
+    std::cout << "\n[12/12] Benchmarking reactor dispatch (prefetch hints)...\n";
+    results.push_back(benchmark_reactor_dispatch(true));
+    print_result(results.back());
+
     std::cout << "\n========================================\n";
     std::cout << "         Benchmark Summary\n";
     std::cout << "========================================\n";
@@ -1,13 +1,34 @@
 #include "katana/core/arena.hpp"
+#include "katana/core/http.hpp"
 #include "katana/core/router.hpp"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string>
 #include <string_view>
 #include <vector>
 
+// katana_gen output for the synthetic specs (see CMakeLists.txt), present when the tools are
+// built. Each header declares namespace generated, so each goes into a namespace of its own;
+// its includes are above.
+#if defined(KATANA_ROUTER_BENCH_CODEGEN)
+namespace spec_10 {
+#include "routes_10/generated_routes.hpp"
+}
+namespace spec_100 {
+#include "routes_100/generated_routes.hpp"
+}
+namespace spec_1000 {
+#include "routes_1000/generated_routes.hpp"
+}
+#endif
+
 using namespace std::chrono;
 using namespace katana;
 using namespace katana::http;
@@ -52,7 +73,8 @@ benchmark_result bench_dispatch(const std::string& name,
                                 const router& r,
                                 const std::vector<std::string_view>& paths,
                                 method m,
-                                size_t iterations) {
+                                size_t iterations,
+                                route_cache* cache = nullptr) {
     std::vector<double> latencies;
     latencies.reserve(iterations);
 
@@ -66,7 +88,8 @@ benchmark_result bench_dispatch(const std::string& name,
         auto req = make_request(path, m, arena);
 
         auto t0 = steady_clock::now();
-        auto res = dispatch_or_problem(r, req, ctx);
+        auto res = cache ? dispatch_or_problem(r, req, ctx, *cache)
+                         : dispatch_or_problem(r, req, ctx);
         auto t1 = steady_clock::now();
 
         if (res.status >= 400) {
@@ -96,6 +119,172 @@ benchmark_result bench_dispatch(const std::string& name,
     return result;
 }
 
+path_pattern pattern_from(std::string_view path) {
+    path_pattern pattern{};
+    auto split = path_pattern::split_path(path);
+    for (size_t i = 0; i < split.count; ++i) {
+        auto segment = split.parts[i];
+        if (segment.front() == '{') {
+            auto name = segment.substr(1, segment.size() - 2);
+            pattern.segments[i] = path_segment{segment_kind::parameter, name};
+            pattern.param_names[pattern.param_count++] = name;
+        } else {
+            pattern.segments[i] = path_segment{segment_kind::literal, segment};
+            ++pattern.literal_count;
+        }
+    }
+    pattern.segment_count = split.count;
+    return pattern;
+}
+
+// The router's lookup before route_index: every route matched in turn.
+route_index::lookup_result linear_find(std::span<const route_entry> routes,
+                                       std::span<const std::string_view> segments,
+                                       method m) {
+    route_index::lookup_result out;
+    int best_score = -1;
+    for (size_t i = 0; i < routes.size(); ++i) {
+        path_params candidate_params{};
+        if (!routes[i].pattern.match_segments(segments, segments.size(), candidate_params)) {
+            continue;
+        }
+        out.path_matched = true;
+        out.allowed_methods_mask |= method_bit(routes[i].method);
+        if (routes[i].method != m) {
+            continue;
+        }
+        int score = routes[i].pattern.specificity_score();
+        if (out.route == route_index::NO_ROUTE || score > best_score) {
+            out.route = static_cast<uint32_t>(i);
+            best_score = score;
+        }
+    }
+    return out;
+}
+
+template <typename Find>
+double lookup_ns(Find&& find,
+                 const std::vector<path_pattern::split_result>& paths,
+                 size_t iterations,
+                 uint64_t& checksum) {
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto& split = paths[i % paths.size()];
+        auto found = find(std::span<const std::string_view>(split.parts.data(), split.count));
+        checksum += found.route + found.allowed_methods_mask;
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return static_cast<double>(elapsed) / static_cast<double>(iterations);
+}
+
+template <typename GeneratedRoutes>
+void bench_lookup_strategies(size_t route_count,
+                             const GeneratedRoutes& generated_routes,
+                             route_lookup_fn generated_find) {
+    handler_fn ok_handler = [](const request&, request_context&) {
+        return response::ok("ok", "text/plain");
+    };
+
+    std::vector<route_entry> routes;
+    std::vector<std::string> uris;
+    for (const auto& generated : generated_routes) {
+        routes.push_back(route_entry{generated.method, pattern_from(generated.path), ok_handler});
+        std::string uri(generated.path);
+        if (auto brace = uri.find("{id}"); brace != std::string::npos) {
+            uri.replace(brace, 4, "42");
+        }
+        if (std::find(uris.begin(), uris.end(), uri) == uris.end()) {
+            uris.push_back(std::move(uri));
+        }
+    }
+    uris.push_back("/api/v1/missing");
+    uris.push_back("/api/v2/res0");
+
+    std::vector<path_pattern::split_result> paths;
+    for (const auto& uri : uris) {
+        paths.push_back(path_pattern::split_path(uri));
+    }
+
+    route_index index(routes);
+    auto linear = [&](std::span<const std::string_view> segments) {
+        return linear_find(routes, segments, method::get);
+    };
+    auto indexed = [&](std::span<const std::string_view> segments) {
+        return index.find(segments, method::get);
+    };
+    auto generated = [&](std::span<const std::string_view> segments) {
+        return generated_find(segments, method::get);
+    };
+
+    uint64_t mismatches = 0;
+    for (const auto& split : paths) {
+        std::span<const std::string_view> segments(split.parts.data(), split.count);
+        auto expected = linear(segments);
+        for (auto found : {indexed(segments), generated(segments)}) {
+            if (found.route != expected.route ||
+                found.allowed_methods_mask != expected.allowed_methods_mask ||
+                found.path_matched != expected.path_matched) {
+                ++mismatches;
+            }
+        }
+    }
+
+    const size_t iterations = route_count >= 1000 ? 200000 : 1000000;
+    uint64_t checksum = 0;
+    std::cout << "\n=== Route lookup (" << route_count << " routes, " << paths.size()
+              << " paths) ===\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Linear scan:        " << lookup_ns(linear, paths, iterations, checksum)
+              << " ns/op\n";
+    std::cout << "route_index:        " << lookup_ns(indexed, paths, iterations, checksum)
+              << " ns/op\n";
+    std::cout << "katana_gen lookup:  " << lookup_ns(generated, paths, iterations, checksum)
+              << " ns/op\n";
+    std::cout << "Mismatches: " << mismatches << " (checksum " << checksum << ")\n";
+}
+
+struct passthrough_layer {
+    template <typename Next>
+    result<response> operator()(const request&, request_context&, Next&& next) const {
+        return next();
+    }
+};
+
+struct noop_hooks {
+    std::optional<response> before(const request&, request_context&) const {
+        return std::nullopt;
+    }
+    void after(const request&, request_context&, result<response>&) const {}
+};
+
+// Three layers as runtime middleware_fn entries vs the same shape fixed at compile time.
+void bench_middleware_chains(const handler_fn& handler, size_t iterations) {
+    auto passthrough = [](const request&, request_context&, next_fn next) { return next(); };
+    std::array<middleware_fn, 3> layers = {
+        middleware_fn(passthrough), middleware_fn(passthrough), middleware_fn(passthrough)};
+
+    route_entry runtime_routes[] = {
+        {method::get,
+         path_pattern::from_literal<"/chain">(),
+         handler,
+         make_middleware_chain(layers)},
+    };
+    route_entry compiled_routes[] = {
+        {method::get,
+         path_pattern::from_literal<"/chain">(),
+         handler,
+         make_middleware_chain<passthrough_layer, noop_hooks, passthrough_layer>()},
+    };
+    router runtime_router(runtime_routes);
+    router compiled_router(compiled_routes);
+    const std::vector<std::string_view> paths = {"/chain"};
+
+    print_result(bench_dispatch(
+        "Middleware x3 (runtime chain)", runtime_router, paths, method::get, iterations));
+    print_result(bench_dispatch(
+        "Middleware x3 (compiled chain)", compiled_router, paths, method::get, iterations));
+}
+
 int main() {
     handler_fn ok_handler = [](const request&, request_context&) {
         return response::ok("ok", "text/plain");
@@ -145,14 +334,32 @@ int main() {
     (void)warmup;
 
     auto hit = bench_dispatch("Router dispatch (hits)", r, happy_paths, method::get, iterations);
+    auto cached = bench_dispatch("Router dispatch (hits, route cache)",
+                                 r,
+                                 happy_paths,
+                                 method::get,
+                                 iterations,
+                                 &route_cache::local());
     auto miss =
         bench_dispatch("Router dispatch (not found)", r, not_found_paths, method::get, iterations);
     auto method_na =
         bench_dispatch("Router dispatch (405)", r, happy_paths, method::post, iterations);
 
     print_result(hit);
+    print_result(cached);
+    std::cout << "Route cache: " << route_cache::local().hits() << " hits, "
+              << route_cache::local().misses() << " misses\n";
     print_result(miss);
     print_result(method_na);
 
+    bench_middleware_chains(ok_handler, iterations);
+
+#if defined(KATANA_ROUTER_BENCH_CODEGEN)
+    bench_lookup_strategies(10, spec_10::generated::routes, &spec_10::generated::find_route);
+    bench_lookup_strategies(100, spec_100::generated::routes, &spec_100::generated::find_route);
+    bench_lookup_strategies(
+        1000, spec_1000::generated::routes, &spec_1000::generated::find_route);
+#endif
+
     return 0;
 }
@@ -182,7 +182,7 @@ inline const katana::http::router& make_router(api_handler& handler) {
                    })
         },
     };
-    static katana::http::router router_instance(route_entries);
+    static katana::http::router router_instance(route_entries, &find_route);
     return router_instance;
 }
 
@@ -4,6 +4,7 @@
 #include "katana/core/http.hpp"
 #include "katana/core/router.hpp"
 #include <array>
+#include <cstdint>
 #include <span>
 #include <string_view>
 
@@ -48,6 +49,70 @@ namespace route_metadata {
 
 } // namespace route_metadata
 
+// Route lookup for make_router's table, fixed at generation time: a perfect hash on
+// (segment 0, segment count) picks the one bucket a path can match, and its routes
+// are checked in the order katana::http::router prefers them.
+namespace route_dispatch {
+inline constexpr size_t key_position = 0;
+inline constexpr uint32_t hash_seed = 0;
+inline constexpr size_t hash_mask = 7;
+inline constexpr std::array<int32_t, 8> slot_bucket = {
+    0, -1, -1, -1, -1, -1, -1, -1,
+};
+inline constexpr std::array<std::string_view, 1> bucket_key = {
+    "user",
+};
+inline constexpr std::array<uint8_t, 1> bucket_segments = {
+    2,
+};
+// Bucket for paths with no keyed literal, by segment count; -1 when none.
+inline constexpr std::array<int32_t, katana::http::MAX_ROUTE_SEGMENTS + 1> fallback_bucket = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1,
+};
+} // namespace route_dispatch
+
+inline katana::http::route_index::lookup_result
+find_route(std::span<const std::string_view> segments, katana::http::method m) noexcept {
+    katana::http::route_index::lookup_result out;
+    [[maybe_unused]] auto hit = [&](uint32_t route, katana::http::method route_method) {
+        out.path_matched = true;
+        out.allowed_methods_mask |= katana::http::method_bit(route_method);
+        if (route_method == m && out.route == katana::http::route_index::NO_ROUTE) {
+            out.route = route;
+        }
+    };
+
+    const size_t count = segments.size();
+    if (count > katana::http::MAX_ROUTE_SEGMENTS) {
+        return out;
+    }
+    int32_t bucket = route_dispatch::fallback_bucket[count];
+    if (count > route_dispatch::key_position) {
+        const auto& key = segments[route_dispatch::key_position];
+        const auto slot =
+            katana::http::route_key_hash(route_dispatch::hash_seed, key, count) &
+            route_dispatch::hash_mask;
+        const int32_t keyed = route_dispatch::slot_bucket[slot];
+        if (keyed >= 0) {
+            const auto index = static_cast<size_t>(keyed);
+            if (route_dispatch::bucket_segments[index] == count &&
+                route_dispatch::bucket_key[index] == key) {
+                bucket = keyed;
+            }
+        }
+    }
+
+    switch (bucket) {
+    case 0:
+        if (segments[1] == "register") hit(0, katana::http::method::post);
+        break;
+    default:
+        break;
+    }
+    return out;
+}
+
 // Compile-time validations
 static_assert(route_count > 0, "At least one route must be defined");
 } // namespace generated
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace katana {
+
+// Per-thread cache of power-of-two byte blocks. Owners that need a large buffer only for the
+// duration of one request (the HTTP parser) borrow from here instead of keeping it, so memory
+// follows the requests in flight rather than the number of connections.
+class buffer_pool {
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 4096;
+    static constexpr size_t MAX_BLOCK_SIZE = 16UL * 1024UL * 1024UL;
+    // Bytes kept cached per thread; blocks released beyond this go back to the allocator.
+    static constexpr size_t MAX_CACHED_BYTES = 32UL * 1024UL * 1024UL;
+
+    buffer_pool() = default;
+    ~buffer_pool() noexcept;
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    static buffer_pool& local() noexcept;
+
+    // Capacity of the block acquire(size) returns: size rounded up to a power of two, at
+    // least MIN_BLOCK_SIZE. Zero if size exceeds MAX_BLOCK_SIZE.
+    [[nodiscard]] static size_t block_size_for(size_t size) noexcept;
+
+    // nullptr on allocation failure or size > MAX_BLOCK_SIZE.
+    [[nodiscard]] uint8_t* acquire(size_t size) noexcept;
+    // `capacity` must be the block_size_for() value the block was acquired with.
+    void release(uint8_t* block, size_t capacity) noexcept;
+
+    [[nodiscard]] size_t cached_bytes() const noexcept { return cached_bytes_; }
+
+private:
+    static constexpr size_t CLASS_COUNT = 13; // 4 KB .. 16 MB
+    static constexpr size_t MAX_BLOCKS_PER_CLASS = 16;
+
+    struct size_class {
+        std::array<uint8_t*, MAX_BLOCKS_PER_CLASS> blocks{};
+        size_t count = 0;
+    };
+
+    [[nodiscard]] static size_t class_index(size_t capacity) noexcept;
+
+    std::array<size_class, CLASS_COUNT> classes_{};
+    size_t cached_bytes_ = 0;
+};
+
+} // namespace katana
@@ -1,12 +1,25 @@
 #pragma once
 
 #include <cstdint>
+#include <string_view>
+#include <vector>
 
 namespace katana {
 
+struct numa_node {
+    uint32_t id = 0;
+    std::vector<uint32_t> cpus;
+};
+
 struct cpu_info {
     static uint32_t core_count() noexcept;
     static bool pin_thread_to_core(uint32_t core_id) noexcept;
+
+    // NUMA nodes that have CPUs, read from /sys/devices/system/node. Without that topology
+    // (non-Linux, no sysfs) a single node 0 holding cores 0..core_count()-1.
+    static std::vector<numa_node> numa_nodes();
+    // Parses a sysfs cpulist such as "0-3,8,10-11\n"; stops at the first malformed entry.
+    static std::vector<uint32_t> parse_cpu_list(std::string_view list);
 };
 
 } // namespace katana
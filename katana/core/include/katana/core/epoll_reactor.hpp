@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fd_event.hpp"
+#include "fd_table.hpp"
 #include "inplace_function.hpp"
 #include "metrics.hpp"
 #include "result.hpp"
@@ -10,7 +11,6 @@
 #include <atomic>
 #include <chrono>
 #include <exception>
-#include <queue>
 #include <string_view>
 #include <sys/epoll.h>
 #include <unordered_map>
@@ -34,12 +34,27 @@ struct timeout_config {
     std::chrono::milliseconds idle_timeout{60000};
 };
 
+struct epoll_poll_options {
+    // Before blocking in epoll_wait the reactor polls the epoll set and its task queue for up
+    // to this long; producers skip the eventfd write meanwhile. Zero blocks straight away.
+    std::chrono::microseconds spin_budget{0};
+    // Kernel busy polling of the watched sockets' NIC queues (EPIOCSPARAMS on the epoll fd,
+    // Linux 6.9+). Best effort; see epoll_reactor::kernel_busy_poll().
+    uint32_t busy_poll_usecs = 0;
+    uint16_t busy_poll_budget = 0;
+    bool prefer_busy_poll = false;
+    // Dispatch each batch's writable events before its readable ones, so queued output keeps
+    // draining while new requests pile up.
+    bool writable_first = false;
+};
+
 class epoll_reactor {
 public:
     static constexpr size_t DEFAULT_MAX_PENDING_TASKS = 10000;
 
     explicit epoll_reactor(int32_t max_events = 128,
-                           size_t max_pending_tasks = DEFAULT_MAX_PENDING_TASKS);
+                           size_t max_pending_tasks = DEFAULT_MAX_PENDING_TASKS,
+                           const epoll_poll_options& options = {});
     ~epoll_reactor() noexcept;
 
     epoll_reactor(const epoll_reactor&) = delete;
@@ -64,6 +79,10 @@ public:
 
     void refresh_fd_timeout(int32_t fd);
 
+    // Object the fd's callback works on (e.g. its connection). The dispatch loop prefetches it
+    // together with the fd's state before running the batch's callbacks.
+    void set_fd_prefetch_hint(int32_t fd, const void* object) noexcept;
+
     bool schedule(task_fn task);
 
     bool schedule_after(std::chrono::milliseconds delay, task_fn task);
@@ -71,17 +90,25 @@ public:
     void set_exception_handler(exception_handler handler);
 
     const reactor_metrics& metrics() const noexcept { return metrics_; }
+    // For components running on this reactor that publish their own counters here.
+    reactor_metrics& metrics() noexcept { return metrics_; }
 
     [[nodiscard]] uint64_t get_load_score() const noexcept;
 
+    // Whether the kernel accepted the busy-poll parameters.
+    [[nodiscard]] bool kernel_busy_poll() const noexcept { return kernel_busy_poll_; }
+
 private:
-    using fd_wheel_timer = wheel_timer<2048, 8>;
+    // One wheel for fd timeouts and schedule_after tasks; the latter are wrapped with the
+    // reactor pointer, hence the larger callback.
+    using reactor_wheel_timer = wheel_timer<1, inplace_function<void(), 160>>;
 
     struct alignas(64) fd_state {
         event_callback callback;
         event_type events{event_type::none};
-        fd_wheel_timer::timeout_id timeout_id{0};
+        reactor_wheel_timer::timeout_id timeout_id{0};
         bool has_timeout{false};
+        const void* prefetch_hint{nullptr};
 
         timeout_config timeouts{};
         std::chrono::steady_clock::time_point last_activity{};
@@ -91,38 +118,40 @@ private:
     struct timer_entry {
         std::chrono::steady_clock::time_point deadline;
         task_fn task;
-
-        bool operator>(const timer_entry& other) const { return deadline > other.deadline; }
     };
 
-    result<void> process_events(int32_t timeout_ms);
+    result<int32_t> process_events(int32_t timeout_ms);
+    result<int32_t> spin_then_wait(int32_t timeout_ms);
+    void dispatch_event(const epoll_event& event);
     void process_tasks();
     void process_timers(std::chrono::steady_clock::time_point now);
-    void process_wheel_timer();
+    void run_delayed_task(const task_fn& task);
     int32_t calculate_timeout(std::chrono::steady_clock::time_point now) const;
     void
     handle_exception(std::string_view location, std::exception_ptr ex, int32_t fd = -1) noexcept;
-    void schedule_fd_timeout(int32_t fd, fd_state& state);
-    void handle_fd_timeout(int32_t fd);
+    void schedule_fd_timeout(uint64_t handle, fd_state& state);
+    void handle_fd_timeout(uint64_t handle);
     void cancel_fd_timeout(fd_state& state);
     void queue_fd_close(int32_t fd);
     void flush_deferred_closes();
     void close_fd_immediate(int32_t fd);
     std::chrono::milliseconds fd_timeout_for(const fd_state& state) const;
-    result<void> ensure_fd_capacity(int32_t fd);
+    result<uint64_t> add_fd(int32_t fd, event_type events);
     std::chrono::milliseconds
     time_until_graceful_deadline(std::chrono::steady_clock::time_point now) const;
 
     int32_t epoll_fd_;
     int32_t wakeup_fd_;
     int32_t max_events_;
+    std::chrono::microseconds spin_budget_;
+    bool writable_first_;
+    bool kernel_busy_poll_ = false;
     std::atomic<bool> running_;
     std::atomic<bool> graceful_shutdown_;
     std::chrono::steady_clock::time_point graceful_shutdown_deadline_;
 
-    std::vector<fd_state> fd_states_;
+    fd_table<fd_state> fds_;
     ring_buffer_queue<task_fn> pending_tasks_;
-    std::priority_queue<timer_entry, std::vector<timer_entry>, std::greater<timer_entry>> timers_;
     ring_buffer_queue<timer_entry> pending_timers_;
 
     alignas(64) std::atomic<size_t> active_fds_{0};
@@ -131,7 +160,7 @@ private:
     exception_handler exception_handler_;
     reactor_metrics metrics_;
 
-    fd_wheel_timer wheel_timer_;
+    reactor_wheel_timer wheel_timer_;
     std::vector<epoll_event> events_buffer_;
     ring_buffer_queue<int32_t> deferred_closes_{2048, false};
 
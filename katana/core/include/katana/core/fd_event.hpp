@@ -3,6 +3,7 @@
 #include "inplace_function.hpp"
 
 #include <cstdint>
+#include <span>
 
 namespace katana {
 
@@ -31,4 +32,12 @@ constexpr bool has_flag(event_type value, event_type flag) noexcept {
 
 using event_callback = inplace_function<void(event_type events), 96>;
 
+// Invoked when a submitted I/O operation finishes. `result` follows CQE semantics:
+// bytes transferred on success, -errno on failure.
+using completion_callback = inplace_function<void(int32_t result), 96>;
+
+// Invoked for each completion of a buffer-selecting op. `data` points into reactor-owned
+// storage and is only valid for the duration of the call.
+using buffer_callback = inplace_function<void(int32_t result, std::span<const uint8_t> data), 96>;
+
 } // namespace katana
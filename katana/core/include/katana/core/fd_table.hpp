@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace katana {
+
+// Per-reactor registry of fd states. States live in fixed-size chunks allocated as fds are
+// registered, so memory follows the number of live fds rather than the highest fd number, and
+// a state never moves while a callback stored in it runs. Every registration gets a handle
+// (slot index plus generation) to hand to the kernel as epoll_event.data.u64 or SQE
+// user_data: once the fd is erased its handle stops resolving, so an event queued for an fd
+// that has since been closed and reused is dropped instead of reaching the new owner.
+template <typename State> class fd_table {
+public:
+    // Handles fit in 56 bits (slot in the low 32, generation in the next 24), leaving room
+    // for the op tag in io_uring user_data. INVALID_HANDLE never resolves.
+    static constexpr uint64_t INVALID_HANDLE = ~uint64_t{0};
+    static constexpr uint32_t GENERATION_MASK = (1u << 24) - 1;
+    static constexpr size_t CHUNK_SIZE = 64;
+
+    fd_table() = default;
+    fd_table(const fd_table&) = delete;
+    fd_table& operator=(const fd_table&) = delete;
+
+    // State registered for `fd`, or nullptr.
+    State* find(int32_t fd) noexcept {
+        uint32_t slot = slot_of(fd);
+        return slot == NO_SLOT ? nullptr : &state_at(slot);
+    }
+
+    [[nodiscard]] uint64_t handle_of(int32_t fd) const noexcept {
+        uint32_t slot = slot_of(fd);
+        return slot == NO_SLOT ? INVALID_HANDLE : make_handle(slot);
+    }
+
+    // State the handle was issued for, or nullptr once that registration was erased.
+    State* resolve(uint64_t handle) noexcept {
+        auto slot = static_cast<uint32_t>(handle);
+        if (slot >= slot_count_) {
+            return nullptr;
+        }
+        auto& c = chunk_of(slot);
+        const size_t i = slot % CHUNK_SIZE;
+        return c.fds[i] >= 0 && (handle >> 32) == c.generations[i] ? &c.states[i] : nullptr;
+    }
+
+    // fd the handle was issued for; only meaningful while resolve(handle) succeeds.
+    [[nodiscard]] int32_t fd_of(uint64_t handle) const noexcept {
+        auto slot = static_cast<uint32_t>(handle);
+        return slot < slot_count_ ? chunk_of(slot).fds[slot % CHUNK_SIZE] : -1;
+    }
+
+    // Pulls every cache line of the handle's state. Stale handles are fine, so this can run
+    // ahead of the generation check.
+    void prefetch(uint64_t handle) const noexcept {
+        auto slot = static_cast<uint32_t>(handle);
+        if (slot < slot_count_) {
+            const auto* bytes =
+                reinterpret_cast<const char*>(&chunk_of(slot).states[slot % CHUNK_SIZE]);
+            for (size_t offset = 0; offset < sizeof(State); offset += 64) {
+                __builtin_prefetch(bytes + offset, 0, 1);
+            }
+        }
+    }
+
+    // Registers `fd` with a default-constructed state, replacing any previous registration.
+    // Throws std::bad_alloc when a new chunk cannot be allocated.
+    uint64_t insert(int32_t fd) {
+        erase(fd);
+        if (static_cast<size_t>(fd) >= slot_of_fd_.size()) {
+            slot_of_fd_.resize(std::max(slot_of_fd_.size() * 2, static_cast<size_t>(fd) + 1),
+                               NO_SLOT);
+        }
+
+        uint32_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            if (slot_count_ == chunks_.size() * CHUNK_SIZE) {
+                chunks_.push_back(std::make_unique<chunk>());
+            }
+            slot = static_cast<uint32_t>(slot_count_++);
+        }
+
+        chunk_of(slot).fds[slot % CHUNK_SIZE] = fd;
+        slot_of_fd_[static_cast<size_t>(fd)] = slot;
+        ++live_;
+        return make_handle(slot);
+    }
+
+    // Drops the registration for `fd`: its state is reset and its handles go stale.
+    bool erase(int32_t fd) noexcept {
+        uint32_t slot = slot_of(fd);
+        if (slot == NO_SLOT) {
+            return false;
+        }
+        auto& c = chunk_of(slot);
+        const size_t i = slot % CHUNK_SIZE;
+        c.states[i] = State{};
+        c.fds[i] = -1;
+        c.generations[i] = (c.generations[i] + 1) & GENERATION_MASK;
+        slot_of_fd_[static_cast<size_t>(fd)] = NO_SLOT;
+        free_slots_.push_back(slot);
+        --live_;
+        return true;
+    }
+
+    // Calls f(fd, state) for each registration. f may erase entries, including the current one.
+    template <typename F> void for_each(F&& f) {
+        for (size_t slot = 0; slot < slot_count_; ++slot) {
+            auto& c = chunk_of(slot);
+            const int32_t fd = c.fds[slot % CHUNK_SIZE];
+            if (fd >= 0) {
+                f(fd, c.states[slot % CHUNK_SIZE]);
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return live_; }
+    [[nodiscard]] size_t capacity() const noexcept { return chunks_.size() * CHUNK_SIZE; }
+
+private:
+    static constexpr uint32_t NO_SLOT = ~uint32_t{0};
+
+    struct chunk {
+        State states[CHUNK_SIZE]{};
+        int32_t fds[CHUNK_SIZE];
+        uint32_t generations[CHUNK_SIZE]{};
+
+        chunk() {
+            for (auto& fd : fds) {
+                fd = -1;
+            }
+        }
+    };
+
+    [[nodiscard]] uint32_t slot_of(int32_t fd) const noexcept {
+        return fd >= 0 && static_cast<size_t>(fd) < slot_of_fd_.size()
+                   ? slot_of_fd_[static_cast<size_t>(fd)]
+                   : NO_SLOT;
+    }
+
+    chunk& chunk_of(size_t slot) noexcept { return *chunks_[slot / CHUNK_SIZE]; }
+    const chunk& chunk_of(size_t slot) const noexcept { return *chunks_[slot / CHUNK_SIZE]; }
+    State& state_at(uint32_t slot) noexcept { return chunk_of(slot).states[slot % CHUNK_SIZE]; }
+
+    [[nodiscard]] uint64_t make_handle(uint32_t slot) const noexcept {
+        return (uint64_t{chunk_of(slot).generations[slot % CHUNK_SIZE]} << 32) | slot;
+    }
+
+    std::vector<std::unique_ptr<chunk>> chunks_;
+    std::vector<uint32_t> slot_of_fd_;
+    std::vector<uint32_t> free_slots_;
+    size_t slot_count_ = 0;
+    size_t live_ = 0;
+};
+
+} // namespace katana
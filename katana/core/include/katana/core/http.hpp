@@ -96,20 +96,35 @@ struct response {
     }
 
     void serialize_into(std::string& out) const;
+    // Appends the status line and headers, through the blank line; `body` is left for the
+    // caller to send separately. Not valid for chunked responses.
+    void append_head_to(std::string& out) const;
     [[nodiscard]] std::string serialize() const;
     [[nodiscard]] std::string serialize_chunked(size_t chunk_size = 4096) const;
 
     static response ok(std::string body = "", std::string content_type = "text/plain");
     static response json(std::string body);
     static response error(const problem_details& problem);
+
+private:
+    void append_head(std::string& out, size_t reserve_extra) const;
 };
 
 class parser {
 public:
+    // The input buffer is taken from buffer_pool on the first parse() and returned on reset(),
+    // so an idle parser holds no buffer.
+    static constexpr size_t INITIAL_BUFFER_SIZE = 4096;
+
     explicit parser(monotonic_arena* arena) noexcept : arena_(arena), request_{} {
         request_.headers = headers_map(arena);
-        buffer_ = static_cast<char*>(arena_->allocate(MAX_BUFFER_SIZE, 1));
     }
+    ~parser();
+
+    parser(parser&& other) noexcept;
+    parser& operator=(parser&& other) noexcept;
+    parser(const parser&) = delete;
+    parser& operator=(const parser&) = delete;
 
     enum class state : uint8_t {
         request_line,
@@ -122,14 +137,28 @@ public:
     };
 
     [[nodiscard]] result<state> parse(std::span<const uint8_t> data);
+    // Parses `data` where it lies instead of copying it: the uri, header values and a
+    // Content-Length body of the request are views into `data`, which must stay alive and
+    // unmodified until the request is no longer used. Each call passes everything received
+    // since reset(); if the bytes moved since the last call, parsing starts over. Chunked
+    // bodies are still reassembled, in parser-owned storage released by reset(). Cannot be
+    // mixed with parse() before reset().
+    [[nodiscard]] result<state> parse_in_place(std::span<const uint8_t> data);
 
     [[nodiscard]] bool is_complete() const noexcept { return state_ == state::complete; }
     [[nodiscard]] const request& get_request() const noexcept { return request_; }
     [[nodiscard]] size_t bytes_parsed() const noexcept { return parse_pos_; }
+    [[nodiscard]] size_t buffer_capacity() const noexcept { return storage_capacity_; }
     request&& take_request() { return std::move(request_); }
     void reset(monotonic_arena* arena) noexcept;
 
 private:
+    struct head_line {
+        std::string_view text; // without the CRLF
+        size_t colon;          // offset of the first ':' in text, or npos
+    };
+
+    result<std::optional<head_line>> next_head_line();
     result<state> parse_request_line_state();
     result<state> parse_headers_state();
     result<state> parse_body_state();
@@ -137,26 +166,39 @@ private:
     result<state> parse_chunk_data_state();
     result<state> parse_chunk_trailer_state();
 
+    result<state> run();
+    void restart() noexcept;
+
     result<void> process_request_line(std::string_view line);
-    result<void> process_header_line(std::string_view line);
+    result<void> process_header_line(std::string_view line, size_t colon);
+    void store_header(field f, std::string_view value) noexcept;
     void compact_buffer();
+    [[nodiscard]] bool reserve_buffer(size_t size) noexcept;
+    [[nodiscard]] bool reserve_chunked_body(size_t size) noexcept;
+    void release_buffer() noexcept;
+    void release_chunked_body() noexcept;
 
     monotonic_arena* arena_;
     state state_ = state::request_line;
     request request_;
-    char* buffer_;
+    char* storage_ = nullptr; // owned by parse(), from buffer_pool
+    size_t storage_capacity_ = 0;
+    const char* buffer_ = nullptr; // storage_, or the caller's bytes in parse_in_place()
     size_t buffer_size_ = 0;
-    size_t buffer_capacity_ = MAX_BUFFER_SIZE;
-    char* chunked_body_ = nullptr;
+    char* chunked_body_ = nullptr; // from buffer_pool, kept across restart()
     size_t chunked_body_size_ = 0;
+    size_t chunked_body_capacity_ = 0;
     field last_header_field_ = field::unknown;
     const char* last_header_name_ = nullptr;
     size_t last_header_name_len_ = 0;
     size_t parse_pos_ = 0;
+    size_t scan_pos_ = 0;          // resume point of the head line being scanned
+    size_t line_colon_ = SIZE_MAX; // first ':' seen in that line so far
     size_t content_length_ = 0;
     size_t current_chunk_size_ = 0;
     size_t header_count_ = 0;
     bool is_chunked_ = false;
+    bool in_place_ = false;
 
     static constexpr size_t COMPACT_THRESHOLD = 2048;
 };
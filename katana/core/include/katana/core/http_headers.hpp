@@ -218,8 +218,23 @@ public:
         unknown_entries_.reserve(UNKNOWN_HEADERS_INLINE_SIZE);
     }
 
-    headers_map(headers_map&&) noexcept = default;
-    headers_map& operator=(headers_map&&) noexcept = default;
+    // The fallback arena is a member, so a moved-to map must point at its own copy of it.
+    headers_map(headers_map&& other) noexcept
+        : arena_(other.arena_), fallback_arena_(other.arena_ ? nullptr : &owned_arena_),
+          owned_arena_(std::move(other.owned_arena_)), known_entries_(other.known_entries_),
+          known_size_(other.known_size_), unknown_entries_(std::move(other.unknown_entries_)) {}
+
+    headers_map& operator=(headers_map&& other) noexcept {
+        if (this != &other) {
+            arena_ = other.arena_;
+            fallback_arena_ = other.arena_ ? nullptr : &owned_arena_;
+            owned_arena_ = std::move(other.owned_arena_);
+            known_entries_ = other.known_entries_;
+            known_size_ = other.known_size_;
+            unknown_entries_ = std::move(other.unknown_entries_);
+        }
+        return *this;
+    }
 
     headers_map(const headers_map&) = delete;
     headers_map& operator=(const headers_map&) = delete;
@@ -237,12 +252,7 @@ public:
         if (!value_ptr)
             return;
 
-        auto& entry = known_entries_[idx];
-        if (!entry.value) {
-            ++known_size_;
-        }
-        entry.value = value_ptr;
-        entry.length = static_cast<uint16_t>(value.size());
+        store_known(idx, value_ptr, value.size());
     }
 
     void set_unknown(std::string_view name, std::string_view value) noexcept {
@@ -255,16 +265,21 @@ public:
         if (!name_ptr || !value_ptr)
             return;
 
-        for (auto& ue : unknown_entries_) {
-            if (ue.name_length == name.size() &&
-                ci_equal_fast(std::string_view(ue.name, ue.name_length), name)) {
-                ue.value = value_ptr;
-                ue.value_length = value.size();
-                return;
-            }
+        store_unknown(std::string_view(name_ptr, name.size()), value_ptr, value.size());
+    }
+
+    // Store the views without copying them into the arena; the caller keeps the bytes alive
+    // for as long as the map is read. Used by parser::parse_in_place.
+    void borrow_known(field f, std::string_view value) noexcept {
+        auto idx = static_cast<size_t>(f);
+        if (idx == static_cast<size_t>(field::unknown) || idx >= KNOWN_HEADERS_COUNT) {
+            return;
         }
+        store_known(idx, value.data(), value.size());
+    }
 
-        unknown_entries_.push_back(unknown_entry{name_ptr, name.size(), value_ptr, value.size()});
+    void borrow_unknown(std::string_view name, std::string_view value) noexcept {
+        store_unknown(name, value.data(), value.size());
     }
 
     void set_view(std::string_view name, std::string_view value) noexcept {
@@ -441,6 +456,28 @@ public:
     }
 
 private:
+    void store_known(size_t idx, const char* value, size_t length) noexcept {
+        auto& entry = known_entries_[idx];
+        if (!entry.value) {
+            ++known_size_;
+        }
+        entry.value = value;
+        entry.length = static_cast<uint16_t>(length);
+    }
+
+    void store_unknown(std::string_view name, const char* value, size_t length) noexcept {
+        for (auto& ue : unknown_entries_) {
+            if (ue.name_length == name.size() &&
+                ci_equal_fast(std::string_view(ue.name, ue.name_length), name)) {
+                ue.value = value;
+                ue.value_length = length;
+                return;
+            }
+        }
+
+        unknown_entries_.push_back(unknown_entry{name.data(), name.size(), value, length});
+    }
+
     monotonic_arena* arena_;
     monotonic_arena* fallback_arena_;
     monotonic_arena owned_arena_{4096};
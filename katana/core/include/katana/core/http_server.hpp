@@ -12,10 +12,13 @@
 
 #include <cerrno>
 #include <chrono>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace katana {
@@ -38,6 +41,9 @@ namespace http {
 /// @endcode
 class server {
 public:
+    // Zero-copy is opt-in: it only pays off for large bodies on NICs that avoid the copy.
+    static constexpr size_t DEFAULT_ZEROCOPY_THRESHOLD = SIZE_MAX;
+
     /// Construct server with a router
     explicit server(const router& rt) : router_(rt) {}
 
@@ -69,12 +75,57 @@ public:
         return *this;
     }
 
+    /// Accept each connection on the reactor pinned to the CPU that received it (reuseport
+    /// listeners only; see reactor_pool_config::enable_cpu_steering)
+    server& cpu_steering(bool enable = true) {
+        cpu_steering_ = enable;
+        return *this;
+    }
+
+    /// Move keep-alive connections that sit idle between requests off reactors whose load
+    /// score is well above the coldest reactor's (epoll backend; see
+    /// reactor_pool_config::enable_connection_migration for the thresholds)
+    server& connection_migration(bool enable = true) {
+        connection_migration_ = enable;
+        return *this;
+    }
+
+    /// Poll for up to `budget` before each reactor blocks in epoll_wait, trading idle CPU for
+    /// wakeup latency (epoll backend; see epoll_poll_options)
+    server& spin_budget(std::chrono::microseconds budget) {
+        spin_budget_ = budget;
+        return *this;
+    }
+
+    /// Handle each event batch's writable sockets before its readable ones so pending
+    /// responses keep flushing under load (epoll backend; see epoll_poll_options)
+    server& writable_first(bool enable = true) {
+        writable_first_ = enable;
+        return *this;
+    }
+
+    /// Remember routing decisions for exact request paths in a per-reactor cache, so repeated
+    /// paths skip matching (see http::route_cache). Hits and misses are published as
+    /// route_cache_hits/route_cache_misses in the reactor metrics.
+    server& hot_route_cache(bool enable = true) {
+        hot_route_cache_ = enable;
+        return *this;
+    }
+
     /// Set graceful shutdown timeout
     server& graceful_shutdown(std::chrono::milliseconds timeout) {
         shutdown_timeout_ = timeout;
         return *this;
     }
 
+    /// Send response bodies of at least `bytes` with zero-copy (SEND_ZC on io_uring,
+    /// MSG_ZEROCOPY on epoll); smaller bodies are copied. SIZE_MAX, the default, disables
+    /// zero-copy; 32 KiB is a reasonable starting point when enabling it.
+    server& zerocopy_threshold(size_t bytes) {
+        zerocopy_threshold_ = bytes;
+        return *this;
+    }
+
     /// Set callback to be called when server starts
     server& on_start(std::function<void()> callback) {
         on_start_callback_ = std::move(callback);
@@ -98,23 +149,90 @@ public:
     int run();
 
 private:
+    // Pipelined requests answered from one read are written together, capped per batch.
+    static constexpr size_t MAX_PIPELINED_RESPONSES = 64;
+
+    struct queued_response {
+        size_t head_offset = 0;
+        size_t head_size = 0;
+        std::string body;
+        // Written with zero-copy on its own send once its head is out (see zerocopy_threshold).
+        bool zerocopy = false;
+    };
+
     struct connection_state {
         tcp_socket socket;
         io_buffer read_buffer;
-        io_buffer write_buffer;
+        // Responses waiting to be written, in request order. Heads are serialized back to back
+        // into one scratch string whose capacity is kept across batches; bodies are the
+        // handlers' strings, written in place.
+        std::string heads;
+        std::vector<queued_response> responses;
+        size_t current = 0;      // first response not yet fully written
+        size_t current_sent = 0; // bytes of it already written
+        // iovecs over the unsent output; on io_uring they must outlive the writev.
+        scatter_gather_write output;
         monotonic_arena arena;
         parser http_parser;
         std::unique_ptr<fd_watch> watch;
+        bool close_after_write = false;
+        bool waiting_writable = false;
+        bool send_in_flight = false;
+        bool closing = false;
+        // io_uring: the recv is cancelled while read_buffer is over MAX_BUFFER_SIZE behind a
+        // send in flight (recv_paused), and re-armed once its last completion has arrived
+        // (recv_stopped) and the buffer has drained.
+        bool recv_paused = false;
+        bool recv_stopped = false;
+        // epoll: bodies whose MSG_ZEROCOPY sends are still referenced by the kernel, tagged
+        // with the socket's send count that completes them.
+        std::deque<std::pair<uint32_t, std::string>> pinned_bodies;
 
+        // Buffers allocate on first use so idle keep-alive connections stay small.
         explicit connection_state(tcp_socket sock)
-            : socket(std::move(sock)), read_buffer(8192), write_buffer(8192), arena(8192),
-              http_parser(&arena) {}
+            : socket(std::move(sock)), arena(8192), http_parser(&arena) {}
     };
 
-    void handle_connection(connection_state& state, reactor& r);
-    void accept_connection(reactor& r,
-                           tcp_listener& listener,
-                           std::vector<std::unique_ptr<connection_state>>& connections);
+    enum class request_status : uint8_t { incomplete, respond, respond_and_close };
+
+    request_status process_request(connection_state& state, size_t zerocopy_threshold);
+    request_status process_pipelined(connection_state& state, size_t zerocopy_threshold);
+    static void queue_response(connection_state& state, response& resp, size_t zerocopy_threshold);
+    static bool has_output(const connection_state& state) noexcept;
+    static bool zerocopy_pending(const connection_state& state) noexcept;
+    static std::span<const uint8_t> unsent_body(const connection_state& state) noexcept;
+    static void gather_output(connection_state& state);
+    static void advance_output(connection_state& state, size_t bytes) noexcept;
+    static void reset_output(connection_state& state);
+    void accept_connection(reactor& r, int32_t fd);
+    // Returns true when the connection is idle between requests: nothing buffered, nothing
+    // left to write and the socket drained, so it may move to another reactor.
+    bool handle_connection(connection_state& state, reactor& r);
+    void release_sent_bodies(connection_state& state);
+
+#if !defined(KATANA_USE_IO_URING)
+    void watch_connection(std::shared_ptr<connection_state> state, reactor& r);
+    void migrate_if_hot(std::shared_ptr<connection_state> state, reactor& r);
+#endif
+
+#if defined(KATANA_USE_IO_URING)
+    // Completion-driven connection loop: a multishot recv fed from the reactor's provided
+    // buffers stays armed for the connection's lifetime, except while a client pipelines
+    // faster than it reads its responses, and each in-flight op holds a reference to the
+    // connection so its buffers outlive the kernel.
+    using connection_ptr = std::shared_ptr<connection_state>;
+
+    void start_receive(const connection_ptr& state, reactor& r);
+    void on_receive(const connection_ptr& state,
+                    reactor& r,
+                    int32_t res,
+                    std::span<const uint8_t> data);
+    void start_send(const connection_ptr& state, reactor& r);
+    void on_send(const connection_ptr& state, reactor& r, int32_t res);
+    void serve_buffered(const connection_ptr& state, reactor& r);
+    void resume_receive(const connection_ptr& state, reactor& r);
+    void close_connection(const connection_ptr& state, reactor& r);
+#endif
 
     const router& router_;
     std::string host_ = "0.0.0.0";
@@ -122,10 +240,17 @@ private:
     size_t worker_count_ = 1;
     int32_t backlog_ = 1024;
     bool reuseport_ = true;
+    bool connection_migration_ = false;
+    bool cpu_steering_ = false;
+    bool writable_first_ = false;
+    bool hot_route_cache_ = false;
     std::chrono::milliseconds shutdown_timeout_{5000};
+    std::chrono::microseconds spin_budget_{0};
+    size_t zerocopy_threshold_ = DEFAULT_ZEROCOPY_THRESHOLD;
     std::function<void()> on_start_callback_;
     std::function<void()> on_stop_callback_;
     std::function<void(const request&, const response&)> on_request_callback_;
+    reactor_pool* pool_ = nullptr; // set while run() is serving
 };
 
 } // namespace http
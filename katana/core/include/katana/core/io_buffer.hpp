@@ -43,6 +43,8 @@ public:
 
     void clear() noexcept;
     void reserve(size_t new_capacity);
+    // Releases the storage of an empty buffer; the next write allocates again.
+    void shrink_to_fit() noexcept;
 
 private:
     void ensure_writable(size_t bytes);
@@ -62,8 +64,6 @@ private:
 
     static constexpr size_t COMPACT_THRESHOLD = 4096;
     static constexpr size_t INITIAL_CAPACITY = 64;
-    static constexpr size_t STATIC_SCRATCH_CAPACITY = 65536; // 64 KB scratch reused per thread
-    alignas(64) static thread_local uint8_t static_scratch_[STATIC_SCRATCH_CAPACITY];
 };
 
 class scatter_gather_read {
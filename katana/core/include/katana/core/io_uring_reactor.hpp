@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fd_event.hpp"
+#include "fd_table.hpp"
 #include "inplace_function.hpp"
 #include "metrics.hpp"
 #include "result.hpp"
@@ -10,10 +11,14 @@
 
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <exception>
 #include <liburing.h>
-#include <queue>
+#include <memory>
+#include <span>
 #include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unordered_map>
 #include <vector>
 
@@ -35,13 +40,29 @@ struct timeout_config {
     std::chrono::milliseconds idle_timeout{60000};
 };
 
+struct io_uring_setup_options {
+    // Kernel thread polls the SQ; submissions stop needing io_uring_enter while it is awake.
+    bool sqpoll = false;
+    uint32_t sqpoll_idle_ms = 1000;
+    // Only the reactor thread submits. The ring starts disabled and is enabled by run().
+    bool single_issuer = false;
+    // Completion work runs when the reactor waits instead of via IPIs. Needs single_issuer.
+    bool defer_taskrun = false;
+};
+
 class io_uring_reactor {
 public:
     static constexpr size_t DEFAULT_MAX_PENDING_TASKS = 10000;
     static constexpr size_t DEFAULT_RING_SIZE = 4096;
+    static constexpr uint32_t PROVIDED_BUFFER_COUNT = 1024;
+    static constexpr uint32_t PROVIDED_BUFFER_SIZE = 4096;
+    static constexpr uint32_t FIXED_FILE_TABLE_SIZE = 65536;
 
+    // SQEs prepared by any call below are queued and flushed once per loop iteration together
+    // with the wait for completions, so a busy iteration costs a single io_uring_enter.
     explicit io_uring_reactor(size_t ring_size = DEFAULT_RING_SIZE,
-                              size_t max_pending_tasks = DEFAULT_MAX_PENDING_TASKS);
+                              size_t max_pending_tasks = DEFAULT_MAX_PENDING_TASKS,
+                              const io_uring_setup_options& options = {});
     ~io_uring_reactor() noexcept;
 
     io_uring_reactor(const io_uring_reactor&) = delete;
@@ -66,6 +87,48 @@ public:
 
     void refresh_fd_timeout(int32_t fd);
 
+    // Object the fd's callback works on; prefetched with the fd's state ahead of each batch
+    // of poll completions.
+    void set_fd_prefetch_hint(int32_t fd, const void* object) noexcept;
+
+    // Completion-based I/O: the operation itself is submitted to the ring and the callback
+    // receives the byte count (or -errno). Buffers, and the iovec array for writev, must stay
+    // valid until the callback runs. send and writev target sockets and never raise SIGPIPE.
+    result<void> submit_recv(int32_t fd, std::span<uint8_t> buffer, completion_callback callback);
+    result<void>
+    submit_send(int32_t fd, std::span<const uint8_t> data, completion_callback callback);
+    result<void> submit_writev(int32_t fd, std::span<const iovec> iov, completion_callback callback);
+
+    // IORING_OP_SEND_ZC: the kernel transmits straight from `data` instead of copying it. The
+    // callback runs once, with the send result, after the kernel's notification that it no
+    // longer references the pages; only then may `data` be freed or modified. Pays off for
+    // payloads of tens of KB and up; check supports_send_zc() first.
+    result<void>
+    submit_send_zc(int32_t fd, std::span<const uint8_t> data, completion_callback callback);
+    [[nodiscard]] bool supports_send_zc() const noexcept { return send_zc_supported_; }
+
+    // Multishot ops stay armed across completions. Accept reports one client fd (>= 0) or
+    // -errno per call and stays armed until cancel_ops; after EMFILE, ENFILE, ENOBUFS or ENOMEM
+    // it is re-armed ACCEPT_RETRY_DELAY later. Recv reports bytes from the reactor's
+    // provided-buffer ring, so no memory is pinned per connection while it is idle. Both finish
+    // with a last callback carrying res <= 0 (0 = peer closed for recv, -ECANCELED after
+    // cancel_ops).
+    result<void> submit_multishot_accept(int32_t listener_fd, completion_callback callback);
+    result<void> submit_multishot_recv(int32_t fd, buffer_callback callback);
+    static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{10};
+
+    // Cancels every in-flight completion op on fd; their callbacks observe -ECANCELED.
+    result<void> cancel_ops(int32_t fd);
+    // Cancels only fd's multishot recv, so a send in flight on it carries on. Buffers already
+    // received are still delivered; the last callback observes -ECANCELED.
+    result<void> cancel_recv(int32_t fd);
+
+    // Installs fd in the ring's registered file table at slot == fd, the same index as its
+    // fd_state. Completion ops on it then skip the per-op file lookup. The table holds its own
+    // reference to the file, so unregister_file must run before the fd is closed.
+    result<void> register_file(int32_t fd);
+    result<void> unregister_file(int32_t fd);
+
     bool schedule(task_fn task);
 
     bool schedule_after(std::chrono::milliseconds delay, task_fn task);
@@ -73,66 +136,127 @@ public:
     void set_exception_handler(exception_handler handler);
 
     const reactor_metrics& metrics() const noexcept { return metrics_; }
+    // For components running on this reactor that publish their own counters here.
+    reactor_metrics& metrics() noexcept { return metrics_; }
 
     [[nodiscard]] uint64_t get_load_score() const noexcept;
 
 private:
-    using fd_wheel_timer = wheel_timer<2048, 8>;
+    // One wheel for fd timeouts and schedule_after tasks; the latter are wrapped with the
+    // reactor pointer, hence the larger callback.
+    using reactor_wheel_timer = wheel_timer<1, inplace_function<void(), 160>>;
 
+    // SQE user_data layout: low 8 bits carry the op_type, the rest carries the fd (poll ops)
+    // or the pending_ops_ slot (completion ops).
     enum class op_type : uint8_t {
         poll_add,
         poll_remove,
         cancel,
+        recv,
+        send,
+        writev,
+        accept_multishot,
+        recv_multishot,
+        send_zc,
     };
 
+    enum class registration_state : uint8_t { untried, active, unavailable };
+
+    static constexpr uint16_t PROVIDED_BUFFER_GROUP = 0;
+
+    static constexpr uint64_t USER_DATA_TAG_BITS = 8;
+
+    static constexpr uint64_t make_user_data(op_type type, uint64_t payload) noexcept {
+        return (payload << USER_DATA_TAG_BITS) | static_cast<uint64_t>(type);
+    }
+
     struct alignas(64) fd_state {
         // Hot data - frequently accessed
         event_callback callback;
         event_type events;
-        fd_wheel_timer::timeout_id timeout_id = 0;
+        reactor_wheel_timer::timeout_id timeout_id = 0;
         bool has_timeout = false;
         bool registered = false;
+        bool poll_armed = false;
+        const void* prefetch_hint = nullptr;
 
         // Cold data - rarely accessed
-        char padding1[64 - sizeof(event_callback) - sizeof(event_type) -
-                      sizeof(fd_wheel_timer::timeout_id) - sizeof(bool) * 2];
-
         timeout_config timeouts;
         Timeout activity_timer;
     };
 
+    struct pending_op {
+        completion_callback callback;
+        buffer_callback on_data;
+        int32_t fd = -1;
+        op_type type = op_type::recv;
+        // send_zc: result of the send CQE, reported once the notification CQE arrives.
+        int32_t deferred_result = 0;
+        // accept: waiting out ACCEPT_RETRY_DELAY with nothing in the ring.
+        bool parked = false;
+        // writev: the sendmsg header, which the kernel may read after submission.
+        msghdr msg{};
+    };
+
     struct timer_entry {
         std::chrono::steady_clock::time_point deadline;
         task_fn task;
-
-        bool operator>(const timer_entry& other) const { return deadline > other.deadline; }
     };
 
-    result<void> submit_poll_add(int32_t fd, event_type events);
-    result<void> submit_poll_remove(int32_t fd);
+    // Polls carry the fd_table handle as their user_data payload.
+    result<void> submit_poll_add(int32_t fd, uint64_t handle, event_type events);
+    result<void> submit_poll_update(uint64_t handle, event_type events);
+    result<void> submit_poll_remove(uint64_t handle);
+    io_uring_sqe* get_sqe();
+    result<void> flush_submissions();
+    uint64_t acquire_op(int32_t fd,
+                        op_type type,
+                        completion_callback callback,
+                        buffer_callback on_data = {});
+    void release_op(uint64_t slot);
+    void complete_op(uint64_t slot, int32_t res);
+    void complete_send_zc(uint64_t slot, int32_t res, uint32_t cqe_flags);
+    result<void> arm_multishot(uint64_t slot);
+    void complete_multishot(uint64_t slot, int32_t res, uint32_t cqe_flags);
+    bool park_accept(uint64_t slot);
+    void invoke_multishot(uint64_t slot, int32_t res, std::span<const uint8_t> data, bool last);
+    result<void> ensure_buffer_ring();
+    void recycle_buffer(uint16_t buffer_id) noexcept;
+    result<void> ensure_file_table();
+    [[nodiscard]] bool is_fixed_file(int32_t fd) const noexcept;
+    void use_fixed_file(io_uring_sqe* sqe, int32_t fd) const noexcept;
+    void dispatch_poll(uint64_t handle, int32_t res);
     result<void> process_completions(int32_t timeout_ms);
     void process_tasks();
     void process_timers();
-    void process_wheel_timer();
+    void run_delayed_task(const task_fn& task);
     int32_t calculate_timeout() const;
     void
     handle_exception(std::string_view location, std::exception_ptr ex, int32_t fd = -1) noexcept;
-    void setup_fd_timeout(int32_t fd, fd_state& state);
+    void setup_fd_timeout(uint64_t handle, fd_state& state);
     void cancel_fd_timeout(fd_state& state);
     std::chrono::milliseconds fd_timeout_for(const fd_state& state) const;
-    result<void> ensure_fd_capacity(int32_t fd);
+    result<uint64_t> insert_fd(int32_t fd);
     std::chrono::milliseconds
     time_until_graceful_deadline(std::chrono::steady_clock::time_point now) const;
 
     io_uring ring_;
+    bool ring_disabled_ = false;
+    bool send_zc_supported_ = false;
     int32_t wakeup_fd_;
     std::atomic<bool> running_;
     std::atomic<bool> graceful_shutdown_;
     std::chrono::steady_clock::time_point graceful_shutdown_deadline_;
 
-    std::vector<fd_state> fd_states_;
+    fd_table<fd_state> fds_;
+    // deque: multishot callbacks run in place and may submit new ops, which must not move them.
+    std::deque<pending_op> pending_ops_;
+    std::vector<uint32_t> free_op_slots_;
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    std::unique_ptr<uint8_t[]> buf_ring_storage_;
+    registration_state file_table_state_ = registration_state::untried;
+    std::vector<uint8_t> fixed_files_;
     ring_buffer_queue<task_fn> pending_tasks_;
-    std::priority_queue<timer_entry, std::vector<timer_entry>, std::greater<timer_entry>> timers_;
     ring_buffer_queue<timer_entry> pending_timers_;
 
     alignas(64) std::atomic<size_t> active_fds_{0};
@@ -141,7 +265,7 @@ private:
     exception_handler exception_handler_;
     reactor_metrics metrics_;
 
-    fd_wheel_timer wheel_timer_;
+    reactor_wheel_timer wheel_timer_;
 
     mutable int32_t cached_timeout_ = -1;
     mutable std::chrono::steady_clock::time_point timeout_cached_at_;
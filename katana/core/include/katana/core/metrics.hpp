@@ -13,6 +13,12 @@ struct metrics_snapshot {
     uint64_t timers_fired = 0;
     uint64_t tasks_rejected = 0; // Tasks rejected due to backpressure
     uint64_t fd_timeouts = 0;
+    uint64_t busy_polls = 0;     // Non-blocking polls while spinning before a wait
+    uint64_t busy_poll_hits = 0; // ... that found ready fds
+    uint64_t blocking_waits = 0; // Waits entered after the spin budget ran out
+    uint64_t route_cache_hits = 0; // Published by http::route_cache::publish_to
+    uint64_t route_cache_misses = 0;
+    uint64_t cross_node_tasks = 0; // Filled in by reactor_pool::aggregate_metrics
 
     metrics_snapshot& operator+=(const metrics_snapshot& other) {
         tasks_executed += other.tasks_executed;
@@ -22,6 +28,12 @@ struct metrics_snapshot {
         timers_fired += other.timers_fired;
         tasks_rejected += other.tasks_rejected;
         fd_timeouts += other.fd_timeouts;
+        busy_polls += other.busy_polls;
+        busy_poll_hits += other.busy_poll_hits;
+        blocking_waits += other.blocking_waits;
+        route_cache_hits += other.route_cache_hits;
+        route_cache_misses += other.route_cache_misses;
+        cross_node_tasks += other.cross_node_tasks;
         return *this;
     }
 };
@@ -34,6 +46,11 @@ struct reactor_metrics {
     std::atomic<uint64_t> timers_fired{0};
     std::atomic<uint64_t> tasks_rejected{0}; // Tasks rejected due to backpressure
     std::atomic<uint64_t> fd_timeouts{0};
+    std::atomic<uint64_t> busy_polls{0};
+    std::atomic<uint64_t> busy_poll_hits{0};
+    std::atomic<uint64_t> blocking_waits{0};
+    std::atomic<uint64_t> route_cache_hits{0};
+    std::atomic<uint64_t> route_cache_misses{0};
 
     void reset() {
         tasks_executed.store(0, std::memory_order_relaxed);
@@ -43,6 +60,11 @@ struct reactor_metrics {
         timers_fired.store(0, std::memory_order_relaxed);
         tasks_rejected.store(0, std::memory_order_relaxed);
         fd_timeouts.store(0, std::memory_order_relaxed);
+        busy_polls.store(0, std::memory_order_relaxed);
+        busy_poll_hits.store(0, std::memory_order_relaxed);
+        blocking_waits.store(0, std::memory_order_relaxed);
+        route_cache_hits.store(0, std::memory_order_relaxed);
+        route_cache_misses.store(0, std::memory_order_relaxed);
     }
 
     [[nodiscard]] metrics_snapshot snapshot() const {
@@ -52,7 +74,12 @@ struct reactor_metrics {
                                 exceptions_caught.load(std::memory_order_relaxed),
                                 timers_fired.load(std::memory_order_relaxed),
                                 tasks_rejected.load(std::memory_order_relaxed),
-                                fd_timeouts.load(std::memory_order_relaxed)};
+                                fd_timeouts.load(std::memory_order_relaxed),
+                                busy_polls.load(std::memory_order_relaxed),
+                                busy_poll_hits.load(std::memory_order_relaxed),
+                                blocking_waits.load(std::memory_order_relaxed),
+                                route_cache_hits.load(std::memory_order_relaxed),
+                                route_cache_misses.load(std::memory_order_relaxed)};
     }
 };
 
@@ -3,11 +3,21 @@
 #include "metrics.hpp"
 #include "reactor.hpp"
 #include "reactor_impl.hpp"
+#include "spsc_channel.hpp"
+#include "work_stealing_deque.hpp"
 
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <span>
+#include <sys/socket.h>
 #include <thread>
+#include <type_traits>
+#include <unistd.h>
 #include <vector>
 
 namespace katana {
@@ -18,17 +28,110 @@ struct reactor_pool_config {
     size_t max_pending_tasks = 65536;
     bool enable_adaptive_balancing = true;
     bool enable_thread_pinning = false;
+    // Places reactors by NUMA node (see cpu_info::numa_nodes), spreading them across nodes,
+    // instead of reactor i on CPU i. Each reactor, its queues and timers are constructed on a
+    // thread pinned to its CPU so that first-touch allocation puts them on the local node;
+    // connection state is already allocated by the owning reactor. Implies thread pinning.
+    bool enable_numa_placement = false;
+    // Attaches a SO_ATTACH_REUSEPORT_CBPF program to the listener group that hands each new
+    // connection to the reactor pinned to the CPU that processed the SYN (CPU % reactor_count
+    // for CPUs without a reactor), so the packets, the softirq and the reactor stay on one
+    // core. Implies thread pinning. Falls back to 4-tuple hashing if the kernel refuses it.
+    bool enable_cpu_steering = false;
+    // Gives each reactor a work-stealing deque for reactor_pool::offload(). Off by default:
+    // without it connections never leave their reactor and offload() refuses work.
+    bool enable_work_stealing = false;
+    // Slots per (producer, consumer) channel used by reactor_pool::post().
+    size_t post_channel_capacity = 1024;
+    // Lets servers move connections that are idle between requests from a hot reactor to the
+    // coldest one (see reactor_pool::migration_target). A reactor counts as hot when its
+    // get_load_score() exceeds the coldest one's by migration_min_load_gap and by
+    // migration_load_ratio_percent; it re-checks every migration_check_interval idle points.
+    bool enable_connection_migration = false;
+    uint64_t migration_min_load_gap = 1000;
+    uint32_t migration_load_ratio_percent = 150;
+    uint32_t migration_check_interval = 64;
+
+    // epoll backend only; ignored with io_uring. See epoll_poll_options.
+    uint32_t epoll_spin_budget_us = 0;
+    uint32_t epoll_busy_poll_usecs = 0;
+    uint16_t epoll_busy_poll_budget = 0;
+    bool epoll_prefer_busy_poll = false;
+    bool epoll_writable_first = false;
+
+    // io_uring backend only; ignored with epoll. See io_uring_setup_options.
+    bool io_uring_sqpoll = false;
+    uint32_t io_uring_sqpoll_idle_ms = 1000;
+    bool io_uring_single_issuer = false;
+    bool io_uring_defer_taskrun = false;
 };
 
 class reactor_pool {
 private:
+    // Work handed to offload(): run() on whichever reactor takes it, resume() back on owner.
+    struct offload_job {
+        explicit offload_job(size_t owner_index) noexcept : owner(owner_index) {}
+        virtual ~offload_job() = default;
+        virtual void run() noexcept = 0;
+        virtual void resume() = 0;
+
+        size_t owner;
+    };
+
+    template <typename Work, typename Resume> struct continuation_job final : offload_job {
+        using value_type = std::invoke_result_t<Work&>;
+
+        continuation_job(size_t owner_index, Work w, Resume r)
+            : offload_job(owner_index), work(std::move(w)), then(std::move(r)) {}
+
+        void run() noexcept override {
+            try {
+                if constexpr (std::is_void_v<value_type>) {
+                    work();
+                } else {
+                    value.emplace(work());
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        void resume() override {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            if constexpr (std::is_void_v<value_type>) {
+                then();
+            } else {
+                then(std::move(*value));
+            }
+        }
+
+        Work work;
+        Resume then;
+        std::conditional_t<std::is_void_v<value_type>, bool, std::optional<value_type>> value{};
+        std::exception_ptr error;
+    };
+
     struct reactor_context {
         std::unique_ptr<reactor_impl> reactor;
         std::thread thread;
         std::atomic<bool> running{false};
+        // Set once run() has returned: cleared `running` alone still allows a graceful drain.
+        std::atomic<bool> exited{false};
         std::atomic<uint64_t> load_score{0};
-        uint32_t core_id{0};
+        uint32_t index{0};
+        uint32_t core_id{0}; // CPU the reactor is pinned to
+        uint32_t numa_node{0};
+        // Tasks this reactor handed to reactors on other nodes through the pool.
+        std::atomic<uint64_t> cross_node_tasks{0};
         int32_t listener_fd{-1};
+        std::unique_ptr<work_stealing_deque<offload_job*>> jobs;
+        // Set while a drain of this reactor's incoming post() channels is scheduled.
+        alignas(64) std::atomic<bool> drain_scheduled{false};
+        uint32_t migration_countdown{0}; // owner only
+        // Jobs this reactor ran for others whose resume found every queue full; this reactor only.
+        std::vector<offload_job*> stalled_completions;
     };
 
 public:
@@ -125,8 +228,64 @@ public:
 
     size_t select_reactor() noexcept;
 
+    [[nodiscard]] uint32_t reactor_cpu(size_t index) const noexcept {
+        return reactors_[index % reactors_.size()]->core_id;
+    }
+    [[nodiscard]] uint32_t reactor_node(size_t index) const noexcept {
+        return reactors_[index % reactors_.size()]->numa_node;
+    }
+
     [[nodiscard]] metrics_snapshot aggregate_metrics() const;
 
+    // Index of the reactor running the calling thread, if it belongs to this pool.
+    [[nodiscard]] std::optional<size_t> current_reactor_index() const noexcept;
+
+    // Moves CPU-heavy work off the calling reactor: `work()` runs on whichever reactor steals
+    // it first (idle ones are asked), then `resume(result)` runs back on the calling reactor,
+    // so connection state is only ever touched by its owner. If `work` throws, the exception
+    // reaches the owner's exception handler instead of `resume`. Returns false, without
+    // running anything, when called off a reactor thread or without enable_work_stealing.
+    template <typename Work, typename Resume> bool offload(Work work, Resume resume) {
+        auto owner = current_reactor_index();
+        if (!owner || !reactors_[*owner]->jobs) {
+            return false;
+        }
+        submit_job(new continuation_job<Work, Resume>(*owner, std::move(work), std::move(resume)));
+        return true;
+    }
+
+    // Runs `task` on reactor `target`. From a reactor thread the task goes through the
+    // dedicated channel from the calling reactor to the target, and a burst of posts costs the
+    // target a single wakeup; from any other thread it falls back to reactor::schedule().
+    // Returns false if the channel (or task queue) is full.
+    bool post(size_t target, task_fn task);
+    // Posts tasks in order until one does not fit; returns how many were taken (moved from).
+    size_t post_batch(size_t target, std::span<task_fn> tasks);
+
+    [[nodiscard]] uint64_t posted_tasks() const noexcept {
+        return posted_tasks_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t post_wakeups() const noexcept {
+        return post_wakeups_.load(std::memory_order_relaxed);
+    }
+
+    // Called by a reactor at a point where one of its connections could move; returns the
+    // reactor it should move to, or nothing if this reactor is not hot enough (or migration is
+    // disabled, or the caller is not one of the pool's reactors). Each returned target counts
+    // as one migration.
+    std::optional<size_t> migration_target() noexcept;
+
+    [[nodiscard]] uint64_t migrated_connections() const noexcept {
+        return migrated_connections_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t offloaded_jobs() const noexcept {
+        return offloaded_jobs_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t stolen_jobs() const noexcept {
+        return stolen_jobs_.load(std::memory_order_relaxed);
+    }
+
     template <typename AcceptHandler>
     result<void> start_listening(uint16_t port, AcceptHandler&& handler) {
         for (auto& ctx : reactors_) {
@@ -151,18 +310,111 @@ public:
                 return res;
             }
         }
+        steer_listeners_by_cpu();
         return {};
     }
 
+    // Per-connection variant of start_listening: handler(reactor, client_fd) runs once for
+    // every accepted socket, on the reactor that owns the listener.
+    template <typename ConnectionHandler>
+    result<void> start_accepting(uint16_t port, ConnectionHandler&& handler) {
+        for (auto& ctx : reactors_) {
+            auto listener_fd = create_listener_socket_reuseport(port);
+            if (listener_fd < 0) {
+                return std::unexpected(std::error_code(errno, std::system_category()));
+            }
+
+            ctx->listener_fd = listener_fd;
+
+            auto res = accept_on(*ctx->reactor, listener_fd, handler);
+            if (!res) {
+                close(listener_fd);
+                return res;
+            }
+        }
+        steer_listeners_by_cpu();
+        return {};
+    }
+
+    // io_uring keeps a single multishot accept armed on the listener, so an accept storm costs
+    // no syscalls; epoll drains accept4 on each readiness edge. Running out of descriptors or
+    // memory pauses accepting for ACCEPT_RETRY_DELAY rather than stopping it: the reactor
+    // re-arms the multishot op, and on epoll a timer drains again, as the connections left in
+    // the backlog raise no new edge.
+    template <typename ConnectionHandler>
+    static result<void> accept_on(reactor_impl& r, int32_t listener_fd, ConnectionHandler handler) {
+#if defined(KATANA_USE_IO_URING)
+        return r.submit_multishot_accept(listener_fd, [handler, &r](int32_t res) {
+            if (res >= 0) {
+                handler(r, res);
+            }
+        });
+#else
+        return r.register_fd(listener_fd,
+                             event_type::readable | event_type::edge_triggered,
+                             [handler, listener_fd, &r](event_type events) {
+                                 if (has_flag(events, event_type::readable)) {
+                                     drain_accepts(r, listener_fd, handler);
+                                 }
+                             });
+#endif
+    }
+
+    static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{10};
+
 private:
     size_t select_least_loaded() noexcept;
+    void place_reactors(std::vector<std::unique_ptr<reactor_context>>& contexts);
+    std::unique_ptr<reactor_impl> make_reactor() const;
+    void note_cross_node(size_t from, size_t to, uint64_t tasks) noexcept;
+
+    void submit_job(offload_job* job);
+    void run_offloaded(size_t thief);
+    void complete_job(offload_job* job, size_t thief);
+    void retry_stalled(size_t thief);
+
+    spsc_channel<task_fn>& channel(size_t producer, size_t consumer);
+    void request_drain(size_t consumer);
+    void drain_posts(size_t consumer);
 
     void worker_thread(reactor_context* ctx);
 
+#if !defined(KATANA_USE_IO_URING)
+    template <typename ConnectionHandler>
+    static void
+    drain_accepts(reactor_impl& r, int32_t listener_fd, const ConnectionHandler& handler) {
+        while (true) {
+            int32_t fd = ::accept4(listener_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd >= 0) {
+                handler(r, fd);
+                continue;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                r.schedule_after(ACCEPT_RETRY_DELAY, [&r, listener_fd, handler]() {
+                    drain_accepts(r, listener_fd, handler);
+                });
+            }
+            return;
+        }
+    }
+#endif
+
     static int32_t create_listener_socket_reuseport(uint16_t port);
+    void steer_listeners_by_cpu() noexcept;
 
     std::vector<std::unique_ptr<reactor_context>> reactors_;
     reactor_pool_config config_;
+    // reactor_count() squared channels, indexed producer * reactor_count() + consumer and
+    // created by their producer on first use.
+    std::unique_ptr<std::atomic<spsc_channel<task_fn>*>[]> channels_;
+    std::atomic<uint64_t> migrated_connections_{0};
+    std::atomic<uint64_t> posted_tasks_{0};
+    std::atomic<uint64_t> post_wakeups_{0};
+    std::atomic<uint64_t> offloaded_jobs_{0};
+    std::atomic<uint64_t> stolen_jobs_{0};
 };
 
 } // namespace katana
@@ -4,18 +4,25 @@
 #include "function_ref.hpp"
 #include "http.hpp"
 #include "inplace_function.hpp"
+#include "metrics.hpp"
 #include "problem.hpp"
 #include "result.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace katana::http {
 
@@ -30,11 +37,96 @@ template <size_t N> struct fixed_string {
 
 enum class segment_kind : uint8_t { literal, parameter };
 
+// Declared type of a path parameter: {name} takes any non-empty segment, {name:int64} and
+// {name:uuid} only segments that convert, so a route whose parameter does not parse does not
+// match the path at all.
+enum class param_type : uint8_t { string, int64, uuid };
+
 struct path_segment {
     segment_kind kind{segment_kind::literal};
     std::string_view value{};
+    param_type type{param_type::string};
+};
+
+struct uuid_value {
+    std::array<uint8_t, 16> bytes;
+
+    friend bool operator==(const uuid_value&, const uuid_value&) = default;
+};
+
+union param_value {
+    int64_t int64;
+    uuid_value uuid;
 };
 
+namespace detail {
+
+inline int hex_digit(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// 8-4-4-4-12 hex digits, either case.
+inline bool parse_uuid(std::string_view text, uuid_value& out) noexcept {
+    if (text.size() != 36) {
+        return false;
+    }
+    size_t byte = 0;
+    for (size_t i = 0; i < text.size();) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (text[i] != '-') {
+                return false;
+            }
+            ++i;
+            continue;
+        }
+        const int high = hex_digit(text[i]);
+        const int low = hex_digit(text[i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out.bytes[byte++] = static_cast<uint8_t>((high << 4) | low);
+        i += 2;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Converts a path segment as a parameter of `type`. Empty segments never match.
+[[nodiscard]] inline bool
+parse_path_param(param_type type, std::string_view text, param_value& out) noexcept {
+    if (text.empty()) {
+        return false;
+    }
+    switch (type) {
+    case param_type::string:
+        return true;
+    case param_type::int64: {
+        const char* end = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), end, out.int64);
+        return ec == std::errc() && ptr == end;
+    }
+    case param_type::uuid:
+        return detail::parse_uuid(text, out.uuid);
+    }
+    return false;
+}
+
+[[nodiscard]] inline bool valid_path_param(param_type type, std::string_view text) noexcept {
+    param_value scratch;
+    return parse_path_param(type, text, scratch);
+}
+
+// Captured parameters in pattern order, so position i is the route's i-th {...} segment.
 struct path_params {
     using param_entry = std::pair<std::string_view, std::string_view>;
 
@@ -45,6 +137,30 @@ struct path_params {
         }
     }
 
+    // Adds `value` converted as `type`; false, adding nothing, when it does not convert.
+    [[nodiscard]] bool
+    add(std::string_view name, std::string_view value, param_type type) noexcept {
+        param_value converted;
+        if (!parse_path_param(type, value, converted)) {
+            return false;
+        }
+        if (size_ < MAX_PATH_PARAMS) {
+            values_[size_] = converted;
+        }
+        add(name, value);
+        return true;
+    }
+
+    [[nodiscard]] std::string_view at(size_t index) const noexcept {
+        return entries_[index].second;
+    }
+
+    // Converted values; `index` must be an {name:int64} or {name:uuid} parameter respectively.
+    [[nodiscard]] int64_t int64_at(size_t index) const noexcept { return values_[index].int64; }
+    [[nodiscard]] const uuid_value& uuid_at(size_t index) const noexcept {
+        return values_[index].uuid;
+    }
+
     [[nodiscard]] std::optional<std::string_view> get(std::string_view name) const noexcept {
         for (size_t i = 0; i < size_; ++i) {
             if (entries_[i].first == name) {
@@ -54,6 +170,8 @@ struct path_params {
         return std::nullopt;
     }
 
+    void clear() noexcept { size_ = 0; }
+
     [[nodiscard]] size_t size() const noexcept { return size_; }
     [[nodiscard]] std::span<const param_entry> entries() const noexcept {
         return std::span<const param_entry>(entries_.data(), size_);
@@ -61,6 +179,7 @@ struct path_params {
 
 private:
     std::array<param_entry, MAX_PATH_PARAMS> entries_{};
+    std::array<param_value, MAX_PATH_PARAMS> values_{};
     size_t size_{0};
 };
 
@@ -72,9 +191,11 @@ struct request_context {
 struct path_pattern {
     std::array<path_segment, MAX_ROUTE_SEGMENTS> segments{};
     std::array<std::string_view, MAX_PATH_PARAMS> param_names{};
+    std::array<param_type, MAX_PATH_PARAMS> param_types{};
     size_t segment_count{0};
     size_t param_count{0};
     size_t literal_count{0};
+    size_t typed_param_count{0};
 
     template <fixed_string Str> static consteval path_pattern from_literal() {
         path_pattern pattern{};
@@ -122,11 +243,29 @@ struct path_pattern {
                 }
 
                 auto name = segment.substr(1, segment.size() - 2);
-                pattern.segments[segment_index] =
-                    path_segment{segment_kind::parameter, std::string_view{name}};
+                auto type = param_type::string;
+                if (size_t colon = name.find(':'); colon != std::string_view::npos) {
+                    const auto type_name = name.substr(colon + 1);
+                    name = name.substr(0, colon);
+                    if (name.empty()) {
+                        throw "parameter name cannot be empty";
+                    }
+                    if (type_name == "int64") {
+                        type = param_type::int64;
+                    } else if (type_name == "uuid") {
+                        type = param_type::uuid;
+                    } else if (type_name != "string") {
+                        throw "unknown parameter type (expected string, int64 or uuid)";
+                    }
+                }
+                pattern.segments[segment_index] = path_segment{segment_kind::parameter, name, type};
                 pattern.param_names[param_index] = name;
+                pattern.param_types[param_index] = type;
                 ++param_index;
                 ++pattern.param_count;
+                if (type != param_type::string) {
+                    ++pattern.typed_param_count;
+                }
             } else {
                 pattern.segments[segment_index] = path_segment{segment_kind::literal, segment};
                 ++pattern.literal_count;
@@ -188,10 +327,9 @@ struct path_pattern {
                     return false;
                 }
             } else {
-                if (actual.empty()) {
+                if (!out.add(param_names[param_index], actual, segment.type)) {
                     return false;
                 }
-                out.add(param_names[param_index], actual);
                 ++param_index;
             }
         }
@@ -215,8 +353,16 @@ struct path_pattern {
         return match_segments(parts, split.count, out);
     }
 
+    // More literals first, then fewer parameters, then more of them typed.
+    [[nodiscard]] static constexpr int
+    specificity_score(size_t literals, size_t params, size_t typed_params) noexcept {
+        return static_cast<int>((literals * 16 + (MAX_ROUTE_SEGMENTS - params)) *
+                                    (MAX_PATH_PARAMS + 1) +
+                                typed_params);
+    }
+
     [[nodiscard]] int specificity_score() const noexcept {
-        return static_cast<int>(literal_count * 16 + (MAX_ROUTE_SEGMENTS - param_count));
+        return specificity_score(literal_count, param_count, typed_param_count);
     }
 };
 
@@ -226,13 +372,21 @@ using middleware_fn =
     inplace_function<result<response>(const request&, request_context&, next_fn), 160>;
 
 struct middleware_chain {
+    using compiled_fn = result<response> (*)(const request&, request_context&, const handler_fn&);
+
     const middleware_fn* ptr{nullptr};
     size_t size{0};
+    compiled_fn compiled{nullptr}; // set by make_middleware_chain<Mw...>()
 
-    [[nodiscard]] bool empty() const noexcept { return size == 0 || ptr == nullptr; }
+    [[nodiscard]] bool empty() const noexcept {
+        return compiled == nullptr && (size == 0 || ptr == nullptr);
+    }
 
     result<response>
     run(const request& req, request_context& ctx, const handler_fn& handler) const {
+        if (compiled) {
+            return compiled(req, ctx, handler);
+        }
         if (empty()) {
             return handler(req, ctx);
         }
@@ -265,6 +419,60 @@ constexpr middleware_chain make_middleware_chain(const std::array<middleware_fn,
     return middleware_chain{middlewares.data(), N};
 }
 
+namespace detail {
+
+// One function per middleware list, with every layer and its continuation inlined.
+template <typename... Mws> struct middleware_pipeline {
+    static result<response>
+    run(const request& req, request_context& ctx, const handler_fn& handler) {
+        return call<0>(req, ctx, handler);
+    }
+
+    template <size_t I>
+    static result<response>
+    call(const request& req, request_context& ctx, const handler_fn& handler) {
+        if constexpr (I == sizeof...(Mws)) {
+            return handler(req, ctx);
+        } else {
+            using layer = std::tuple_element_t<I, std::tuple<Mws...>>;
+            const layer mw{};
+            if constexpr (requires { mw.before(req, ctx); } || requires(result<response>& res) {
+                              mw.after(req, ctx, res);
+                          }) {
+                if constexpr (requires { mw.before(req, ctx); }) {
+                    if (std::optional<response> early = mw.before(req, ctx)) {
+                        return std::move(*early);
+                    }
+                }
+                result<response> res = call<I + 1>(req, ctx, handler);
+                if constexpr (requires { mw.after(req, ctx, res); }) {
+                    mw.after(req, ctx, res);
+                }
+                return res;
+            } else {
+                return mw(req, ctx, [&]() -> result<response> {
+                    return call<I + 1>(req, ctx, handler);
+                });
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+// Middleware fixed at compile time, run as one function the compiler can inline end to end
+// rather than an indirect call and stack frame per layer. Each Mw is default-constructed per
+// request, so keep them stateless, and provides either
+//   result<response> operator()(const request&, request_context&, auto&& next) const
+// wrapping the rest of the chain like middleware_fn, or one or both hooks
+//   std::optional<response> before(const request&, request_context&) const
+//   void after(const request&, request_context&, result<response>&) const
+// A response from before() ends the chain there; after() of the layers outside it still runs.
+template <typename... Mws> constexpr middleware_chain make_middleware_chain() {
+    static_assert(sizeof...(Mws) > 0, "make_middleware_chain needs at least one middleware");
+    return middleware_chain{nullptr, 0, &detail::middleware_pipeline<Mws...>::run};
+}
+
 struct route_entry {
     http::method method;
     path_pattern pattern;
@@ -272,6 +480,21 @@ struct route_entry {
     middleware_chain middleware{};
 };
 
+// Hash of one path segment and the path's segment count, shared by katana_gen (which picks
+// a seed that makes it collision-free over a spec's routes) and the lookup code it emits.
+inline constexpr uint32_t
+route_key_hash(uint32_t seed, std::string_view segment, size_t segment_count) noexcept {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : segment) {
+        h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    h ^= static_cast<uint32_t>(segment_count) * 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
 inline constexpr uint32_t method_bit(http::method m) noexcept {
     auto idx = static_cast<uint32_t>(m);
     if (idx >= 31 || m == http::method::unknown) {
@@ -318,59 +541,317 @@ struct dispatch_result {
     uint32_t allowed_methods_mask{0};
 };
 
-class router {
+// Routes indexed by path shape, built once from the route table. Literal segments are trie
+// edges, with chains of single-child literal nodes merged into one multi-segment edge, and each
+// node has at most one parameter edge per parameter type, taken only by segments that convert,
+// so a lookup costs the path's depth rather than the number of routes. A path can reach
+// several nodes through different literal/parameter choices; all of them are visited, so the
+// winner (highest specificity_score, then table order) and the Allow mask are exactly those of
+// a scan over every route.
+class route_index {
 public:
-    explicit router(std::span<const route_entry> routes) : routes_(routes) {}
+    static constexpr uint32_t NO_ROUTE = ~uint32_t{0};
 
-    dispatch_result dispatch_with_info(const request& req, request_context& ctx) const {
-        auto path = strip_query(req.uri);
-        auto split = path_pattern::split_path(path);
-        if (split.overflow) {
-            return dispatch_result{
-                std::unexpected(make_error_code(error_code::not_found)), false, 0};
+    struct lookup_result {
+        uint32_t route{NO_ROUTE}; // index into the route table
+        uint32_t allowed_methods_mask{0};
+        bool path_matched{false};
+    };
+
+    explicit route_index(std::span<const route_entry> routes) : routes_(routes) {
+        std::vector<build_node> tree(1);
+        for (size_t i = 0; i < routes.size(); ++i) {
+            const auto& pattern = routes[i].pattern;
+            uint32_t current = 0;
+            for (size_t s = 0; s < pattern.segment_count; ++s) {
+                current = build_child(tree, current, pattern.segments[s]);
+            }
+            tree[current].routes.push_back(static_cast<uint32_t>(i));
+            tree[current].methods |= method_bit(routes[i].method);
         }
-        std::span<const std::string_view> path_segments(split.parts.data(), split.count);
+        emit(tree, 0);
+    }
 
-        const route_entry* best_route = nullptr;
-        path_params best_params;
-        int best_score = -1;
-        bool path_matched = false;
-        uint32_t allowed_methods_mask = 0;
+    [[nodiscard]] lookup_result find(std::span<const std::string_view> path_segments,
+                                     http::method m) const noexcept {
+        lookup_result out;
+        visit(0, path_segments, m, out);
+        return out;
+    }
 
-        for (const auto& entry : routes_) {
-            path_params candidate_params{};
-            if (!entry.pattern.match_segments(path_segments, split.count, candidate_params)) {
-                continue;
+private:
+    static constexpr uint32_t NO_NODE = ~uint32_t{0};
+
+    struct build_node {
+        std::vector<std::pair<std::string_view, uint32_t>> literals;
+        std::vector<std::pair<param_type, uint32_t>> params;
+        uint32_t methods{0};
+        std::vector<uint32_t> routes;
+    };
+
+    struct literal_edge {
+        std::string_view first; // first label segment; siblings are sorted by it
+        uint32_t label_begin{0};
+        uint32_t label_size{0};
+        uint32_t child{NO_NODE};
+    };
+
+    struct node {
+        std::vector<literal_edge> literals;
+        std::vector<std::pair<param_type, uint32_t>> params;
+        uint32_t methods{0};
+        std::vector<uint32_t> routes; // routes ending here, in table order
+    };
+
+    static uint32_t
+    build_child(std::vector<build_node>& tree, uint32_t parent, const path_segment& segment) {
+        if (segment.kind == segment_kind::parameter) {
+            for (const auto& [type, child] : tree[parent].params) {
+                if (type == segment.type) {
+                    return child;
+                }
             }
+            auto child = static_cast<uint32_t>(tree.size());
+            tree[parent].params.emplace_back(segment.type, child);
+            tree.emplace_back();
+            return child;
+        }
+        for (const auto& [label, child] : tree[parent].literals) {
+            if (label == segment.value) {
+                return child;
+            }
+        }
+        auto child = static_cast<uint32_t>(tree.size());
+        tree[parent].literals.emplace_back(segment.value, child);
+        tree.emplace_back();
+        return child;
+    }
 
-            path_matched = true;
-            allowed_methods_mask |= method_bit(entry.method);
-            if (entry.method != req.http_method) {
-                continue;
+    // Copies the subtree at `source` into nodes_, compressing literal chains on the way.
+    uint32_t emit(const std::vector<build_node>& tree, uint32_t source) {
+        const auto index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+
+        const build_node& from = tree[source];
+        node built;
+        built.methods = from.methods;
+        built.routes = from.routes;
+        for (const auto& [type, child] : from.params) {
+            built.params.emplace_back(type, emit(tree, child));
+        }
+
+        for (const auto& [label, first_child] : from.literals) {
+            literal_edge edge;
+            edge.first = label;
+            edge.label_begin = static_cast<uint32_t>(labels_.size());
+            labels_.push_back(label);
+            uint32_t child = first_child;
+            while (tree[child].routes.empty() && tree[child].params.empty() &&
+                   tree[child].literals.size() == 1) {
+                labels_.push_back(tree[child].literals.front().first);
+                child = tree[child].literals.front().second;
             }
+            edge.label_size = static_cast<uint32_t>(labels_.size()) - edge.label_begin;
+            edge.child = emit(tree, child);
+            built.literals.push_back(edge);
+        }
+        std::sort(built.literals.begin(),
+                  built.literals.end(),
+                  [](const literal_edge& a, const literal_edge& b) { return a.first < b.first; });
 
-            int score = entry.pattern.specificity_score();
-            if (!best_route || score > best_score) {
-                best_route = &entry;
-                best_score = score;
-                best_params = candidate_params;
+        nodes_[index] = std::move(built);
+        return index;
+    }
+
+    void visit(uint32_t index,
+               std::span<const std::string_view> rest,
+               http::method m,
+               lookup_result& out) const noexcept {
+        const node& n = nodes_[index];
+        if (rest.empty()) {
+            if (n.routes.empty()) {
+                return;
+            }
+            out.path_matched = true;
+            out.allowed_methods_mask |= n.methods;
+            // Every route of a node has the same shape, hence the same score: the first with
+            // the method is the node's candidate.
+            for (uint32_t route : n.routes) {
+                if (routes_[route].method != m) {
+                    continue;
+                }
+                if (out.route == NO_ROUTE || prefer(route, out.route)) {
+                    out.route = route;
+                }
+                break;
             }
+            return;
         }
 
-        if (!best_route) {
-            if (path_matched) {
-                return dispatch_result{
-                    std::unexpected(make_error_code(error_code::method_not_allowed)),
-                    true,
-                    allowed_methods_mask};
+        auto it = std::lower_bound(
+            n.literals.begin(),
+            n.literals.end(),
+            rest.front(),
+            [](const literal_edge& edge, std::string_view key) { return edge.first < key; });
+        if (it != n.literals.end() && it->first == rest.front() && it->label_size <= rest.size()) {
+            auto label = std::span<const std::string_view>(labels_).subspan(it->label_begin,
+                                                                               it->label_size);
+            if (std::equal(label.begin() + 1, label.end(), rest.begin() + 1)) {
+                visit(it->child, rest.subspan(it->label_size), m, out);
+            }
+        }
+        if (!rest.front().empty()) {
+            for (const auto& [type, child] : n.params) {
+                if (type == param_type::string || valid_path_param(type, rest.front())) {
+                    visit(child, rest.subspan(1), m, out);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] bool prefer(uint32_t candidate, uint32_t current) const noexcept {
+        const int a = routes_[candidate].pattern.specificity_score();
+        const int b = routes_[current].pattern.specificity_score();
+        return a > b || (a == b && candidate < current);
+    }
+
+    std::span<const route_entry> routes_;
+    std::vector<node> nodes_;
+    std::vector<std::string_view> labels_;
+};
+
+// Per-thread cache of routing decisions for exact (method, path) pairs, consulted before the
+// route lookup. Each reactor runs on its own thread and takes its cache from local(), so
+// entries are never shared and need no synchronization. Slots are direct-mapped: a new path
+// replaces whatever shared its slot. Only matches on paths of up to MAX_PATH bytes are kept,
+// with parameters stored as offsets into the path, so a hit rebuilds them without splitting
+// or matching; typed parameters are converted again from their text.
+class route_cache {
+public:
+    static constexpr size_t SLOTS = 256;
+    static constexpr size_t MAX_PATH = 64;
+
+    struct entry {
+        uint64_t owner{0}; // id of the router the decision belongs to
+        uint64_t hash{0};
+        uint32_t route{0};
+        uint32_t allowed_methods_mask{0};
+        http::method method{http::method::unknown};
+        uint8_t path_size{0};
+        uint8_t param_count{0};
+        std::array<std::pair<uint8_t, uint8_t>, MAX_PATH_PARAMS> params{}; // offset, size
+        char path[MAX_PATH]{};
+    };
+
+    static route_cache& local() noexcept {
+        thread_local route_cache cache;
+        return cache;
+    }
+
+    const entry* find(uint64_t owner, http::method m, std::string_view path) noexcept {
+        if (path.size() <= MAX_PATH) {
+            const uint64_t h = hash(m, path);
+            const entry& e = slots_[h & (SLOTS - 1)];
+            if (e.owner == owner && e.hash == h && e.method == m && e.path_size == path.size() &&
+                std::memcmp(e.path, path.data(), path.size()) == 0) {
+                ++hits_;
+                if (metrics_) {
+                    metrics_->route_cache_hits.fetch_add(1, std::memory_order_relaxed);
+                }
+                return &e;
             }
-            return dispatch_result{
-                std::unexpected(make_error_code(error_code::not_found)), false, 0};
         }
+        ++misses_;
+        if (metrics_) {
+            metrics_->route_cache_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
 
-        ctx.params = best_params;
-        return dispatch_result{
-            best_route->middleware.run(req, ctx, best_route->handler), true, allowed_methods_mask};
+    // `params` must view into `path`.
+    void store(uint64_t owner,
+               http::method m,
+               std::string_view path,
+               uint32_t route,
+               uint32_t allowed_methods_mask,
+               const path_params& params) noexcept {
+        if (path.size() > MAX_PATH) {
+            return;
+        }
+        const uint64_t h = hash(m, path);
+        entry& e = slots_[h & (SLOTS - 1)];
+        e.owner = owner;
+        e.hash = h;
+        e.route = route;
+        e.allowed_methods_mask = allowed_methods_mask;
+        e.method = m;
+        e.path_size = static_cast<uint8_t>(path.size());
+        std::memcpy(e.path, path.data(), path.size());
+        e.param_count = static_cast<uint8_t>(params.size());
+        for (size_t i = 0; i < params.size(); ++i) {
+            auto value = params.entries()[i].second;
+            e.params[i] = {static_cast<uint8_t>(value.data() - path.data()),
+                           static_cast<uint8_t>(value.size())};
+        }
+    }
+
+    [[nodiscard]] uint64_t hits() const noexcept { return hits_; }
+    [[nodiscard]] uint64_t misses() const noexcept { return misses_; }
+
+    // hits()/misses() are only readable on the owning thread; this also counts them into the
+    // reactor's metrics, where reactor_pool::aggregate_metrics sums them. nullptr stops it.
+    void publish_to(reactor_metrics* metrics) noexcept { metrics_ = metrics; }
+
+private:
+    static uint64_t hash(http::method m, std::string_view path) noexcept {
+        uint64_t h = 14695981039346656037ull ^ static_cast<uint64_t>(m);
+        for (char c : path) {
+            h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+        return h ^ (h >> 29);
+    }
+
+    std::array<entry, SLOTS> slots_{};
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+    reactor_metrics* metrics_{nullptr};
+};
+
+// Lookup fixed ahead of time for one route table, reporting indices into it. katana_gen emits
+// one per spec as generated::find_route.
+using route_lookup_fn = route_index::lookup_result (*)(std::span<const std::string_view>,
+                                                       http::method) noexcept;
+
+class router {
+public:
+    explicit router(std::span<const route_entry> routes)
+        : routes_(routes), index_(routes), id_(next_id()) {}
+
+    // Dispatches through `lookup` and builds no index of its own.
+    router(std::span<const route_entry> routes, route_lookup_fn lookup)
+        : routes_(routes), index_({}), lookup_(lookup), id_(next_id()) {}
+
+    dispatch_result dispatch_with_info(const request& req, request_context& ctx) const {
+        return dispatch_path(req, ctx, strip_query(req.uri), nullptr);
+    }
+
+    // Same result, answered from `cache` when this method and path were routed before.
+    dispatch_result
+    dispatch_with_info(const request& req, request_context& ctx, route_cache& cache) const {
+        auto path = strip_query(req.uri);
+        if (const auto* hit = cache.find(id_, req.http_method, path)) {
+            const route_entry& route = routes_[hit->route];
+            ctx.params.clear();
+            for (size_t i = 0; i < hit->param_count; ++i) {
+                const auto [offset, size] = hit->params[i];
+                (void)ctx.params.add(route.pattern.param_names[i],
+                                     path.substr(offset, size),
+                                     route.pattern.param_types[i]);
+            }
+            return dispatch_result{
+                route.middleware.run(req, ctx, route.handler), true, hit->allowed_methods_mask};
+        }
+        return dispatch_path(req, ctx, path, &cache);
     }
 
     result<response> dispatch(const request& req, request_context& ctx) const {
@@ -378,6 +859,48 @@ public:
     }
 
 private:
+    static uint64_t next_id() noexcept {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    dispatch_result dispatch_path(const request& req,
+                                  request_context& ctx,
+                                  std::string_view path,
+                                  route_cache* cache) const {
+        auto split = path_pattern::split_path(path);
+        if (split.overflow) {
+            return dispatch_result{
+                std::unexpected(make_error_code(error_code::not_found)), false, 0};
+        }
+        std::span<const std::string_view> path_segments(split.parts.data(), split.count);
+
+        auto found = lookup_ ? lookup_(path_segments, req.http_method)
+                             : index_.find(path_segments, req.http_method);
+        if (found.route == route_index::NO_ROUTE) {
+            if (found.path_matched) {
+                return dispatch_result{
+                    std::unexpected(make_error_code(error_code::method_not_allowed)),
+                    true,
+                    found.allowed_methods_mask};
+            }
+            return dispatch_result{
+                std::unexpected(make_error_code(error_code::not_found)), false, 0};
+        }
+
+        // Parameters are captured for the winning route only.
+        const route_entry& best_route = routes_[found.route];
+        ctx.params.clear();
+        (void)best_route.pattern.match_segments(path_segments, split.count, ctx.params);
+        if (cache) {
+            cache->store(
+                id_, req.http_method, path, found.route, found.allowed_methods_mask, ctx.params);
+        }
+        return dispatch_result{best_route.middleware.run(req, ctx, best_route.handler),
+                               true,
+                               found.allowed_methods_mask};
+    }
+
     static std::string_view strip_query(std::string_view uri) noexcept {
         size_t pos = uri.find('?');
         if (pos == std::string_view::npos) {
@@ -390,6 +913,9 @@ private:
     }
 
     std::span<const route_entry> routes_;
+    route_index index_;
+    route_lookup_fn lookup_{nullptr};
+    uint64_t id_; // tells route_cache entries of different routers apart
 };
 
 inline response map_dispatch_error(dispatch_result result) {
@@ -418,6 +944,13 @@ inline response dispatch_or_problem(const router& r, const request& req, request
     return map_dispatch_error(r.dispatch_with_info(req, ctx));
 }
 
+inline response dispatch_or_problem(const router& r,
+                                    const request& req,
+                                    request_context& ctx,
+                                    route_cache& cache) {
+    return map_dispatch_error(r.dispatch_with_info(req, ctx, cache));
+}
+
 // Helper functor to plug router into existing handler harnesses or server code.
 class router_handler {
 public:
@@ -100,6 +100,136 @@ inline const char* find_crlf(const char* data, size_t len) noexcept {
 #endif
 }
 
+// Result of scanning one line of an HTTP head. Offsets are relative to the scanned data.
+struct line_scan {
+    enum class status : uint8_t { incomplete, line, invalid };
+
+    status result = status::incomplete;
+    // line: offset of the terminating CR. incomplete: bytes that need not be scanned again.
+    size_t end = 0;
+    // First ':' before `end`, or SIZE_MAX.
+    size_t colon = SIZE_MAX;
+};
+
+// Bytes that stop a line scan: controls other than HTAB, DEL and everything >= 0x80. CR and
+// LF are among them; the rest make the line invalid.
+constexpr bool is_line_stop(unsigned char c) noexcept {
+    return (c < 0x20 && c != '\t') || c >= 0x7f;
+}
+
+inline line_scan finish_line_scan(const char* data, size_t len, size_t at, size_t colon) noexcept {
+    if (data[at] != '\r') {
+        return {line_scan::status::invalid, at, colon};
+    }
+    if (at + 1 == len) {
+        return {line_scan::status::incomplete, at, colon};
+    }
+    if (data[at + 1] != '\n') {
+        return {line_scan::status::invalid, at, colon};
+    }
+    return {line_scan::status::line, at, colon};
+}
+
+inline line_scan scan_http_line_scalar(const char* data,
+                                       size_t len,
+                                       size_t from = 0,
+                                       size_t colon = SIZE_MAX) noexcept {
+    for (size_t i = from; i < len; ++i) {
+        const auto c = static_cast<unsigned char>(data[i]);
+        if (is_line_stop(c)) {
+            return finish_line_scan(data, len, i, colon);
+        }
+        if (c == ':' && colon == SIZE_MAX) {
+            colon = i;
+        }
+    }
+    return {line_scan::status::incomplete, len, colon};
+}
+
+#ifdef KATANA_HAS_AVX2
+inline line_scan scan_http_line_avx2(const char* data, size_t len) noexcept {
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i colon_char = _mm256_set1_epi8(':');
+
+    size_t colon = SIZE_MAX;
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+        // Signed compare: bytes >= 0x80 are negative and land with the controls.
+        __m256i stop =
+            _mm256_or_si256(_mm256_cmpgt_epi8(space, chunk), _mm256_cmpeq_epi8(chunk, del));
+        stop = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), stop);
+        auto stop_bits = static_cast<unsigned int>(_mm256_movemask_epi8(stop));
+        auto colon_bits =
+            static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, colon_char)));
+
+        if (stop_bits != 0U) {
+            const auto offset = static_cast<unsigned int>(__builtin_ctz(stop_bits));
+            colon_bits &= (1U << offset) - 1U;
+            if (colon == SIZE_MAX && colon_bits != 0U) {
+                colon = i + static_cast<size_t>(__builtin_ctz(colon_bits));
+            }
+            return finish_line_scan(data, len, i + offset, colon);
+        }
+        if (colon == SIZE_MAX && colon_bits != 0U) {
+            colon = i + static_cast<size_t>(__builtin_ctz(colon_bits));
+        }
+    }
+
+    return scan_http_line_scalar(data, len, i, colon);
+}
+#endif
+
+#ifdef KATANA_HAS_SSE2
+inline line_scan scan_http_line_sse2(const char* data, size_t len) noexcept {
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i colon_char = _mm_set1_epi8(':');
+
+    size_t colon = SIZE_MAX;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+        __m128i stop = _mm_or_si128(_mm_cmpgt_epi8(space, chunk), _mm_cmpeq_epi8(chunk, del));
+        stop = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), stop);
+        auto stop_bits = static_cast<unsigned int>(_mm_movemask_epi8(stop));
+        auto colon_bits =
+            static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, colon_char)));
+
+        if (stop_bits != 0U) {
+            const auto offset = static_cast<unsigned int>(__builtin_ctz(stop_bits));
+            colon_bits &= (1U << offset) - 1U;
+            if (colon == SIZE_MAX && colon_bits != 0U) {
+                colon = i + static_cast<size_t>(__builtin_ctz(colon_bits));
+            }
+            return finish_line_scan(data, len, i + offset, colon);
+        }
+        if (colon == SIZE_MAX && colon_bits != 0U) {
+            colon = i + static_cast<size_t>(__builtin_ctz(colon_bits));
+        }
+    }
+
+    return scan_http_line_scalar(data, len, i, colon);
+}
+#endif
+
+// Single pass over one line of an HTTP head: finds the CRLF, the first colon and any byte
+// that may not appear in a request line or header field (RFC 9110 field-value, no obs-text).
+inline line_scan scan_http_line(const char* data, size_t len) noexcept {
+#ifdef KATANA_HAS_AVX2
+    return scan_http_line_avx2(data, len);
+#elif defined(KATANA_HAS_SSE2)
+    return scan_http_line_sse2(data, len);
+#else
+    return scan_http_line_scalar(data, len);
+#endif
+}
+
 inline const void*
 find_pattern(const void* haystack, size_t hlen, const void* needle, size_t nlen) noexcept {
     if (nlen == 0 || hlen < nlen)
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace katana {
+
+// Bounded single-producer/single-consumer queue. The producer only writes tail_ and the
+// consumer only writes head_, so neither side ever contends on a cache line with the other
+// beyond the index it publishes.
+template <typename T> class spsc_channel {
+public:
+    explicit spsc_channel(size_t capacity = 1024) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        capacity_ = rounded;
+        mask_ = rounded - 1;
+        slots_ = std::make_unique<T[]>(rounded);
+    }
+
+    spsc_channel(const spsc_channel&) = delete;
+    spsc_channel& operator=(const spsc_channel&) = delete;
+
+    // Producer only.
+    bool try_push(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    bool try_pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        slots_[head & mask_] = T{};
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0; // consumer's view of tail_
+
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0; // producer's view of head_
+};
+
+} // namespace katana
@@ -16,12 +16,20 @@ public:
 
     ~tcp_socket() { close(); }
 
-    tcp_socket(tcp_socket&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+    tcp_socket(tcp_socket&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)), zerocopy_(std::exchange(other.zerocopy_, false)),
+          zerocopy_sent_(std::exchange(other.zerocopy_sent_, 0)),
+          zerocopy_completed_(std::exchange(other.zerocopy_completed_, 0)),
+          zerocopy_copied_(std::exchange(other.zerocopy_copied_, false)) {}
 
     tcp_socket& operator=(tcp_socket&& other) noexcept {
         if (this != &other) {
             close();
             fd_ = std::exchange(other.fd_, -1);
+            zerocopy_ = std::exchange(other.zerocopy_, false);
+            zerocopy_sent_ = std::exchange(other.zerocopy_sent_, 0);
+            zerocopy_completed_ = std::exchange(other.zerocopy_completed_, 0);
+            zerocopy_copied_ = std::exchange(other.zerocopy_copied_, false);
         }
         return *this;
     }
@@ -32,6 +40,19 @@ public:
     result<std::span<uint8_t>> read(std::span<uint8_t> buf);
     result<size_t> write(std::span<const uint8_t> data);
 
+    // MSG_ZEROCOPY: the kernel pins `data` instead of copying it, so it must stay untouched until
+    // reap_zerocopy() reports the sends covering it as complete. Falls back to copying writes if
+    // SO_ZEROCOPY cannot be enabled, or for good once the kernel reports it had to copy anyway
+    // (loopback, devices without scatter-gather). Each send call that moved bytes counts as one
+    // send.
+    result<size_t> write_zerocopy(std::span<const uint8_t> data);
+
+    // Drains completion notifications from the socket error queue (surfaced by epoll as
+    // EPOLLERR) and returns the number of zerocopy sends completed so far.
+    result<uint32_t> reap_zerocopy();
+
+    [[nodiscard]] uint32_t zerocopy_sends() const noexcept { return zerocopy_sent_; }
+
     void close() noexcept;
 
     [[nodiscard]] int32_t native_handle() const noexcept { return fd_; }
@@ -41,6 +62,10 @@ public:
 
 private:
     int32_t fd_{-1};
+    bool zerocopy_{false};
+    uint32_t zerocopy_sent_{0};
+    uint32_t zerocopy_completed_{0};
+    bool zerocopy_copied_{false};
 };
 
 } // namespace katana
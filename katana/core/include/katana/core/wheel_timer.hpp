@@ -3,60 +3,62 @@
 #include "inplace_function.hpp"
 
 #include <algorithm>
-#include <cassert>
+#include <array>
+#include <bit>
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
 namespace katana {
 
-template <size_t NumSlots = 512, size_t SlotMs = 100> class wheel_timer {
+// Hierarchical timing wheel: LEVELS wheels of 64 slots, each slot of level L spanning 64^L
+// ticks (1 ms, 64 ms, ~4 s, ~4.4 min, ~4.7 h with the default tick), so about 12 days fit
+// without wrapping; later deadlines park in the last slot of the top level and are re-filed
+// when it comes round. A timer is filed by how far away it is and moves one level down each
+// time its slot comes due, so it is touched at most LEVELS times. Slots are intrusive lists
+// over a pooled entry array: add and cancel are O(1) and cancelled timers leave at once.
+template <size_t TickMs = 1, typename Callback = inplace_function<void(), 128>> class wheel_timer {
 public:
-    using callback_fn = inplace_function<void(), 128>;
+    using callback_fn = Callback;
     using timeout_id = uint64_t;
     using clock = std::chrono::steady_clock;
     using duration = std::chrono::milliseconds;
 
-    static constexpr size_t WHEEL_SIZE = NumSlots;
-    static constexpr size_t TICK_MS = SlotMs;
-    static constexpr size_t COMPACT_INTERVAL_TICKS = 8; // периодическая очистка отменённых
+    static constexpr size_t LEVELS = 5;
+    static constexpr size_t LEVEL_BITS = 6;
+    static constexpr size_t SLOTS_PER_LEVEL = size_t{1} << LEVEL_BITS;
+    static constexpr size_t TICK_MS = TickMs;
+    static constexpr uint64_t MAX_TICKS = (uint64_t{1} << (LEVEL_BITS * LEVELS)) - 1;
 
-    wheel_timer() : current_slot_(0), last_tick_(clock::now()) {
-        slots_.resize(WHEEL_SIZE);
-        entries_.reserve(WHEEL_SIZE);
+    static_assert(TickMs > 0, "wheel_timer tick must be at least 1 ms");
+
+    explicit wheel_timer(clock::time_point start = clock::now()) : origin_(start) {
+        heads_.fill(NIL);
     }
 
     timeout_id add(duration timeout, callback_fn cb) {
-        // Validate callback - use exception instead of assert for release builds
-        if (!cb) {
-            throw std::invalid_argument("wheel_timer::add: callback must be valid");
-        }
-
         if (timeout.count() <= 0) {
             timeout = duration{1};
         }
+        return add_at(clock::now() + timeout, std::move(cb));
+    }
 
-        size_t ticks = (static_cast<size_t>(timeout.count()) + TICK_MS - 1) / TICK_MS;
-        if (ticks == 0) {
-            ticks = 1;
+    // Fires on the first tick() at or after `deadline`; deadlines already passed fire on the
+    // next tick.
+    timeout_id add_at(clock::time_point deadline, callback_fn cb) {
+        // Validate callback - use exception instead of assert for release builds
+        if (!cb) {
+            throw std::invalid_argument("wheel_timer::add: callback must be valid");
         }
 
-        size_t slot_offset = ticks % WHEEL_SIZE;
-        size_t target_slot = (current_slot_ + slot_offset) % WHEEL_SIZE;
-        size_t rounds = ticks / WHEEL_SIZE;
-
         uint32_t index = acquire_entry();
         auto& entry = entries_[index];
         entry.callback = std::move(cb);
-        entry.remaining_rounds = rounds;
-        entry.slot_idx = static_cast<uint32_t>(target_slot);
-        entry.active = true;
-
-        slot_handle handle{index, entry.generation};
-        slots_[target_slot].handles.push_back(handle);
-
-        return make_id(handle);
+        entry.expires = std::max(ticks_until(deadline), now_ + 1);
+        link(index);
+        return make_id(index, entry.generation);
     }
 
     [[nodiscard]] bool cancel(timeout_id id) {
@@ -70,91 +72,79 @@ public:
             return false;
         }
 
-        // Ленивая отмена: помечаем и убираем при ближайшей очистке слота.
-        entry.cancelled = true;
+        unlink(index);
+        release_entry(index);
         return true;
     }
 
+    // Runs every timer whose deadline is at or before `now`. A callback that throws leaves the
+    // rest of its slot for the next call.
     void tick(clock::time_point now = clock::now()) {
-        if (now <= last_tick_) {
-            return;
-        }
-
-        auto elapsed = std::chrono::duration_cast<duration>(now - last_tick_);
-        if (elapsed.count() < static_cast<int64_t>(TICK_MS)) {
-            return;
-        }
+        const uint64_t target = now > origin_ ? elapsed_ticks(now) : 0;
+
+        fire_due();
+        while (now_ < target) {
+            // Ticks with nothing filed are skipped outright.
+            const uint64_t next = pending_entries_ == 0 ? target : next_event_tick();
+            if (next > target) {
+                now_ = target;
+                break;
+            }
 
-        size_t ticks = static_cast<size_t>(elapsed.count()) / TICK_MS;
-        last_tick_ += duration(static_cast<int64_t>(ticks) * static_cast<int64_t>(TICK_MS));
+            now_ = next;
+            for (size_t level = LEVELS - 1; level > 0; --level) {
+                if ((now_ & ((uint64_t{1} << (LEVEL_BITS * level)) - 1)) == 0) {
+                    cascade(level);
+                }
+            }
 
-        for (size_t i = 0; i < ticks; ++i) {
-            advance_slot();
+            // Detach the due slot first: callbacks that re-arm for the next tick land in a
+            // fresh slot rather than the list being drained.
+            if (heads_[slot_of(0, now_)] != NIL) {
+                splice_into_due(slot_of(0, now_));
+            }
+            fire_due();
         }
     }
 
     size_t pending_count() const { return pending_entries_; }
 
+    // Time until the next tick() that has work to do: firing a timer or moving a coarser slot
+    // down a level. Never later than the earliest deadline; O(LEVELS) regardless of how many
+    // timers are pending.
     duration time_until_next_expiration(clock::time_point now = clock::now()) const {
         if (pending_entries_ == 0) {
             return duration::max();
         }
-
-        auto since_last_tick =
-            now > last_tick_ ? std::chrono::duration_cast<duration>(now - last_tick_) : duration{0};
-        auto base = duration(TICK_MS) - std::min(duration(TICK_MS), since_last_tick);
-
-        duration best = duration::max();
-        for (size_t slot = 0; slot < slots_.size(); ++slot) {
-            if (slots_[slot].handles.empty()) {
-                continue;
-            }
-
-            auto offset = slot >= current_slot_ ? slot - current_slot_
-                                                : (WHEEL_SIZE - (current_slot_ - slot));
-
-            for (const auto& handle : slots_[slot].handles) {
-                if (handle.index >= entries_.size()) {
-                    continue;
-                }
-                const auto& entry = entries_[handle.index];
-                if (!entry.active || entry.generation != handle.generation) {
-                    continue;
-                }
-
-                size_t total_ticks = offset + entry.remaining_rounds * WHEEL_SIZE;
-                duration candidate = base + duration(static_cast<int64_t>(total_ticks) *
-                                                     static_cast<int64_t>(TICK_MS));
-                if (candidate < best) {
-                    best = candidate;
-                }
-            }
+        if (heads_[DUE_LIST] != NIL) {
+            return duration{0};
         }
 
-        return best;
+        const uint64_t next = next_event_tick();
+        const auto at = origin_ + duration(static_cast<int64_t>(next * TICK_MS));
+        if (at <= now) {
+            return duration{0};
+        }
+        return std::chrono::ceil<duration>(at - now);
     }
 
 private:
-    struct slot_handle {
-        uint32_t index;
-        uint32_t generation;
-    };
-
-    struct slot_bucket {
-        std::vector<slot_handle> handles;
-    };
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+    // heads_[DUE_LIST]: timers taken off their slot that have yet to run.
+    static constexpr size_t DUE_LIST = LEVELS * SLOTS_PER_LEVEL;
 
     struct entry_data {
         callback_fn callback;
-        size_t remaining_rounds{0};
-        uint32_t slot_idx{0};
+        uint64_t expires{0};
+        uint32_t prev{NIL};
+        uint32_t next{NIL};
+        uint32_t list{0};
         uint32_t generation{1};
         bool active{false};
-        bool cancelled{false};
     };
 
-    static timeout_id make_id(slot_handle handle) {
-        return (static_cast<timeout_id>(handle.generation) << 32) | handle.index;
+    static timeout_id make_id(uint32_t index, uint32_t generation) {
+        return (static_cast<timeout_id>(generation) << 32) | index;
     }
 
     static std::pair<uint32_t, uint32_t> decode_id(timeout_id id) {
@@ -163,98 +153,163 @@ private:
         return {index, generation};
     }
 
-    uint32_t acquire_entry() {
-        uint32_t index;
-        if (!free_list_.empty()) {
-            index = free_list_.back();
-            free_list_.pop_back();
-            auto& entry = entries_[index];
-            ++entry.generation;
-            if (entry.generation == 0) {
-                ++entry.generation;
-            }
-        } else {
-            index = static_cast<uint32_t>(entries_.size());
-            entries_.push_back(entry_data{});
-        }
-        ++pending_entries_;
-        return index;
+    static constexpr size_t slot_of(size_t level, uint64_t tick) {
+        return level * SLOTS_PER_LEVEL +
+               static_cast<size_t>((tick >> (LEVEL_BITS * level)) & (SLOTS_PER_LEVEL - 1));
     }
 
-    void release_entry(uint32_t index) {
-        auto& entry = entries_[index];
-        entry.active = false;
-        entry.cancelled = false;
-        entry.callback = callback_fn{};
-        entry.remaining_rounds = 0;
-        entry.slot_idx = 0;
-        free_list_.push_back(index);
-        if (pending_entries_ > 0) {
-            --pending_entries_;
+    // First tick after now_ at which a non-empty slot comes due, on any level. Only valid
+    // while timers are pending.
+    uint64_t next_event_tick() const {
+        uint64_t next = std::numeric_limits<uint64_t>::max();
+        for (size_t level = 0; level < LEVELS; ++level) {
+            if (occupied_[level] == 0) {
+                continue;
+            }
+            // Rotate so bit k is the slot k + 1 blocks ahead; the current slot ends up in the
+            // top bit, as it can only hold the block a full turn ahead.
+            const size_t shift = LEVEL_BITS * level;
+            const uint64_t current = now_ >> shift;
+            const auto rotation = static_cast<int>((current + 1) & (SLOTS_PER_LEVEL - 1));
+            const auto ahead =
+                static_cast<uint64_t>(std::countr_zero(std::rotr(occupied_[level], rotation))) + 1;
+            next = std::min(next, (current + ahead) << shift);
         }
+        return next;
     }
 
-    void advance_slot() {
-        current_slot_ = (current_slot_ + 1) % WHEEL_SIZE;
-        auto& bucket = slots_[current_slot_];
+    uint64_t elapsed_ticks(clock::time_point now) const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<duration>(now - origin_).count()) /
+               TICK_MS;
+    }
 
-        if ((current_slot_ + 1) < WHEEL_SIZE) {
-            __builtin_prefetch(&slots_[current_slot_ + 1], 0, 3);
+    // First tick at or after `deadline`.
+    uint64_t ticks_until(clock::time_point deadline) const {
+        if (deadline <= origin_) {
+            return 0;
         }
+        const auto ms = std::chrono::ceil<duration>(deadline - origin_).count();
+        return (static_cast<uint64_t>(ms) + TICK_MS - 1) / TICK_MS;
+    }
 
-        if (bucket.handles.empty()) {
-            return;
+    // Files the entry by its distance from now_: level L holds timers 64^L..64^(L+1)-1 ticks
+    // out, in the slot its expiry falls into.
+    void link(uint32_t index) {
+        auto& entry = entries_[index];
+        const uint64_t delta = std::min(entry.expires - std::min(entry.expires, now_), MAX_TICKS);
+        size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << (LEVEL_BITS * (level + 1)))) {
+            ++level;
         }
+        push_front(slot_of(level, now_ + delta), index);
+    }
 
-        auto handles = std::move(bucket.handles);
-        bucket.handles.clear();
-        bucket.handles.reserve(handles.size());
+    void push_front(size_t list, uint32_t index) {
+        auto& entry = entries_[index];
+        entry.list = static_cast<uint32_t>(list);
+        entry.prev = NIL;
+        entry.next = heads_[list];
+        if (entry.next != NIL) {
+            entries_[entry.next].prev = index;
+        } else if (list != DUE_LIST) {
+            occupied_[list / SLOTS_PER_LEVEL] |= uint64_t{1} << (list % SLOTS_PER_LEVEL);
+        }
+        heads_[list] = index;
+    }
 
-        bool should_compact = (++compact_tick_counter_ % COMPACT_INTERVAL_TICKS) == 0;
+    void unlink(uint32_t index) {
+        auto& entry = entries_[index];
+        if (entry.prev != NIL) {
+            entries_[entry.prev].next = entry.next;
+        } else {
+            heads_[entry.list] = entry.next;
+            if (entry.next == NIL) {
+                clear_slot(entry.list);
+            }
+        }
+        if (entry.next != NIL) {
+            entries_[entry.next].prev = entry.prev;
+        }
+        entry.prev = entry.next = NIL;
+    }
 
-        for (size_t i = 0; i < handles.size(); ++i) {
-            auto& handle = handles[i];
+    // Re-files the slot of `level` that became current; its timers all land lower down.
+    void cascade(size_t level) {
+        const size_t slot = slot_of(level, now_);
+        uint32_t index = heads_[slot];
+        heads_[slot] = NIL;
+        clear_slot(slot);
+        while (index != NIL) {
+            const uint32_t next = entries_[index].next;
+            link(index);
+            index = next;
+        }
+    }
 
-            if (i + 1 < handles.size() && handles[i + 1].index < entries_.size()) {
-                __builtin_prefetch(&entries_[handles[i + 1].index], 0, 3);
-            }
+    void splice_into_due(size_t slot) {
+        uint32_t index = heads_[slot];
+        heads_[slot] = NIL;
+        clear_slot(slot);
+        while (index != NIL) {
+            const uint32_t next = entries_[index].next;
+            push_front(DUE_LIST, index);
+            index = next;
+        }
+    }
 
-            if (handle.index >= entries_.size()) {
-                continue;
-            }
-            auto& entry = entries_[handle.index];
-            if (!entry.active || entry.generation != handle.generation) {
-                continue;
-            }
+    void clear_slot(size_t list) {
+        if (list != DUE_LIST) {
+            occupied_[list / SLOTS_PER_LEVEL] &= ~(uint64_t{1} << (list % SLOTS_PER_LEVEL));
+        }
+    }
 
-            if (entry.cancelled) {
-                if (should_compact) {
-                    release_entry(handle.index);
-                } else {
-                    bucket.handles.push_back(handle);
-                }
-                continue;
+    void fire_due() {
+        while (heads_[DUE_LIST] != NIL) {
+            const uint32_t index = heads_[DUE_LIST];
+            if (entries_[index].next != NIL) {
+                __builtin_prefetch(&entries_[entries_[index].next], 0, 3);
             }
+            unlink(index);
+            auto cb = std::move(entries_[index].callback);
+            release_entry(index);
+            cb();
+        }
+    }
 
-            if (entry.remaining_rounds > 0) {
-                --entry.remaining_rounds;
-                bucket.handles.push_back(handle);
-                continue;
-            }
+    uint32_t acquire_entry() {
+        uint32_t index;
+        if (!free_list_.empty()) {
+            index = free_list_.back();
+            free_list_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(entries_.size());
+            entries_.push_back(entry_data{});
+        }
+        entries_[index].active = true;
+        ++pending_entries_;
+        return index;
+    }
 
-            auto cb = std::move(entry.callback);
-            release_entry(handle.index);
-            cb();
+    void release_entry(uint32_t index) {
+        auto& entry = entries_[index];
+        entry.active = false;
+        entry.callback = callback_fn{};
+        ++entry.generation;
+        if (entry.generation == 0) {
+            ++entry.generation;
         }
+        free_list_.push_back(index);
+        --pending_entries_;
     }
 
-    std::vector<slot_bucket> slots_;
+    clock::time_point origin_;
+    uint64_t now_{0};
+    std::array<uint32_t, LEVELS * SLOTS_PER_LEVEL + 1> heads_;
+    // Bit s of occupied_[L] is set while slot s of level L is non-empty.
+    std::array<uint64_t, LEVELS> occupied_{};
     std::vector<entry_data> entries_;
     std::vector<uint32_t> free_list_;
-    size_t current_slot_;
-    clock::time_point last_tick_;
     size_t pending_entries_{0};
-    size_t compact_tick_counter_{0};
 };
 
 } // namespace katana
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace katana {
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models", PPoPP 2013). One owner thread pushes and pops at the bottom; any thread may
+// steal from the top. T must be trivially copyable, typically a pointer.
+template <typename T> class work_stealing_deque {
+    static_assert(std::is_trivially_copyable_v<T>, "work_stealing_deque holds plain values");
+
+public:
+    explicit work_stealing_deque(size_t capacity = 256) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        rings_.push_back(std::make_unique<ring>(rounded));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    // Owner only.
+    void push(T item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        ring* r = ring_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(r->capacity) - 1) {
+            r = grow(r, top, bottom);
+        }
+        r->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Takes the most recently pushed item.
+    std::optional<T> pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        ring* r = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        T item = r->get(bottom);
+        if (top == bottom) {
+            // Last item: race the thieves for it.
+            bool won = top_.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return item;
+    }
+
+    // Any thread. Takes the oldest item; returns nullopt only if the deque was seen empty.
+    std::optional<T> steal() {
+        while (true) {
+            int64_t top = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t bottom = bottom_.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                return std::nullopt;
+            }
+
+            ring* r = ring_.load(std::memory_order_acquire);
+            T item = r->get(top);
+            if (top_.compare_exchange_strong(
+                    top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return item;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+private:
+    struct ring {
+        explicit ring(size_t cap)
+            : capacity(cap), mask(cap - 1), slots(std::make_unique<std::atomic<T>[]>(cap)) {}
+
+        T get(int64_t index) const noexcept {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+        void put(int64_t index, T item) noexcept {
+            slots[static_cast<size_t>(index) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    // Thieves may still be reading the old ring, so it is kept until the deque goes away.
+    ring* grow(ring* old, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<ring>(old->capacity * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        ring* r = bigger.get();
+        rings_.push_back(std::move(bigger));
+        ring_.store(r, std::memory_order_release);
+        return r;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<ring*> ring_{nullptr};
+    std::vector<std::unique_ptr<ring>> rings_;
+};
+
+} // namespace katana
@@ -0,0 +1,60 @@
+#include "katana/core/buffer_pool.hpp"
+
+#include <bit>
+#include <cstdlib>
+
+namespace katana {
+
+buffer_pool::~buffer_pool() noexcept {
+    for (auto& cls : classes_) {
+        for (size_t i = 0; i < cls.count; ++i) {
+            std::free(cls.blocks[i]);
+        }
+    }
+}
+
+buffer_pool& buffer_pool::local() noexcept {
+    thread_local buffer_pool pool;
+    return pool;
+}
+
+size_t buffer_pool::block_size_for(size_t size) noexcept {
+    if (size > MAX_BLOCK_SIZE) {
+        return 0;
+    }
+    return size <= MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : std::bit_ceil(size);
+}
+
+size_t buffer_pool::class_index(size_t capacity) noexcept {
+    return static_cast<size_t>(std::countr_zero(capacity) - std::countr_zero(MIN_BLOCK_SIZE));
+}
+
+uint8_t* buffer_pool::acquire(size_t size) noexcept {
+    size_t capacity = block_size_for(size);
+    if (capacity == 0) {
+        return nullptr;
+    }
+
+    auto& cls = classes_[class_index(capacity)];
+    if (cls.count > 0) {
+        cached_bytes_ -= capacity;
+        return cls.blocks[--cls.count];
+    }
+    return static_cast<uint8_t*>(std::malloc(capacity));
+}
+
+void buffer_pool::release(uint8_t* block, size_t capacity) noexcept {
+    if (!block) {
+        return;
+    }
+
+    auto& cls = classes_[class_index(capacity)];
+    if (cls.count == MAX_BLOCKS_PER_CLASS || cached_bytes_ + capacity > MAX_CACHED_BYTES) {
+        std::free(block);
+        return;
+    }
+    cls.blocks[cls.count++] = block;
+    cached_bytes_ += capacity;
+}
+
+} // namespace katana
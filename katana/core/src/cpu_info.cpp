@@ -1,8 +1,14 @@
 #include "katana/core/cpu_info.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <string>
 #include <thread>
 
 #ifdef __linux__
+#include <dirent.h>
 #include <pthread.h>
 #include <sched.h>
 #endif
@@ -28,4 +34,74 @@ bool cpu_info::pin_thread_to_core(uint32_t core_id) noexcept {
 #endif
 }
 
+std::vector<numa_node> cpu_info::numa_nodes() {
+    std::vector<numa_node> nodes;
+#ifdef __linux__
+    static constexpr const char* NODE_DIR = "/sys/devices/system/node";
+    if (DIR* dir = opendir(NODE_DIR)) {
+        while (dirent* entry = readdir(dir)) {
+            std::string_view name(entry->d_name);
+            if (!name.starts_with("node")) {
+                continue;
+            }
+            uint32_t id = 0;
+            auto [end, ec] = std::from_chars(name.data() + 4, name.data() + name.size(), id);
+            if (ec != std::errc{} || end != name.data() + name.size()) {
+                continue;
+            }
+
+            std::ifstream in(std::string(NODE_DIR) + "/" + std::string(name) + "/cpulist");
+            std::string list((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+            auto cpus = parse_cpu_list(list);
+            if (!cpus.empty()) {
+                nodes.push_back({id, std::move(cpus)});
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const numa_node& a, const numa_node& b) {
+        return a.id < b.id;
+    });
+#endif
+
+    if (nodes.empty()) {
+        numa_node all;
+        for (uint32_t cpu = 0; cpu < core_count(); ++cpu) {
+            all.cpus.push_back(cpu);
+        }
+        nodes.push_back(std::move(all));
+    }
+    return nodes;
+}
+
+std::vector<uint32_t> cpu_info::parse_cpu_list(std::string_view list) {
+    std::vector<uint32_t> cpus;
+    const char* p = list.data();
+    const char* end = list.data() + list.size();
+    while (p < end && *p != '\n') {
+        uint32_t first = 0;
+        auto res = std::from_chars(p, end, first);
+        if (res.ec != std::errc{}) {
+            break;
+        }
+        uint32_t last = first;
+        p = res.ptr;
+        if (p < end && *p == '-') {
+            res = std::from_chars(p + 1, end, last);
+            if (res.ec != std::errc{} || last < first) {
+                break;
+            }
+            p = res.ptr;
+        }
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (p < end && *p == ',') {
+            ++p;
+        }
+    }
+    return cpus;
+}
+
 } // namespace katana
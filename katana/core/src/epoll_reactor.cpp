@@ -8,6 +8,7 @@
 #include <iostream>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <system_error>
 #include <unistd.h>
 
@@ -15,6 +16,26 @@ namespace katana {
 
 namespace {
 
+// <sys/epoll.h> from older libcs lacks the busy-poll ioctl (uapi/linux/eventpoll.h).
+struct epoll_busy_poll_params {
+    uint32_t busy_poll_usecs;
+    uint16_t busy_poll_budget;
+    uint8_t prefer_busy_poll;
+    uint8_t pad;
+};
+constexpr unsigned long EPOLL_SET_BUSY_POLL_PARAMS = _IOW(0x8A, 0x01, epoll_busy_poll_params);
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// epoll data for the eventfd; fd_table never issues this handle.
+constexpr uint64_t WAKEUP_HANDLE = ~uint64_t{0};
+
 constexpr uint32_t to_epoll_events(event_type events) noexcept {
     uint32_t result = 0;
 
@@ -55,8 +76,11 @@ constexpr event_type from_epoll_events(uint32_t events) noexcept {
 
 } // namespace
 
-epoll_reactor::epoll_reactor(int32_t max_events, size_t max_pending_tasks)
-    : epoll_fd_(-1), wakeup_fd_(-1), max_events_(max_events), running_(false),
+epoll_reactor::epoll_reactor(int32_t max_events,
+                             size_t max_pending_tasks,
+                             const epoll_poll_options& options)
+    : epoll_fd_(-1), wakeup_fd_(-1), max_events_(max_events), spin_budget_(options.spin_budget),
+      writable_first_(options.writable_first), running_(false),
       graceful_shutdown_(false), pending_tasks_(max_pending_tasks),
       pending_timers_(max_pending_tasks), exception_handler_([](const exception_context& ctx) {
           std::cerr << "[reactor] Exception in " << ctx.location;
@@ -88,12 +112,19 @@ epoll_reactor::epoll_reactor(int32_t max_events, size_t max_pending_tasks)
 
     epoll_event ev{};
     ev.events = EPOLLIN | EPOLLET;
-    ev.data.fd = wakeup_fd.get();
+    ev.data.u64 = WAKEUP_HANDLE;
     if (epoll_ctl(epoll_fd.get(), EPOLL_CTL_ADD, wakeup_fd.get(), &ev) < 0) {
         throw std::system_error(errno, std::system_category(), "failed to add wakeup fd to epoll");
     }
 
-    fd_states_.reserve(65536);
+    if (options.busy_poll_usecs > 0) {
+        epoll_busy_poll_params params{options.busy_poll_usecs,
+                                      options.busy_poll_budget,
+                                      static_cast<uint8_t>(options.prefer_busy_poll),
+                                      0};
+        kernel_busy_poll_ = ioctl(epoll_fd.get(), EPOLL_SET_BUSY_POLL_PARAMS, &params) == 0;
+    }
+
     events_buffer_.resize(static_cast<size_t>(max_events_));
 
     // Everything succeeded, release ownership from RAII wrappers
@@ -117,50 +148,44 @@ result<void> epoll_reactor::run() {
 
     while (running_.load(std::memory_order_relaxed)) {
         const auto loop_now = std::chrono::steady_clock::now();
-        process_wheel_timer();
         process_timers(loop_now);
         process_tasks();
 
         if (graceful_shutdown_.load(std::memory_order_relaxed)) {
             auto now = loop_now;
             bool has_active_fds = false;
-            for (const auto& state : fd_states_) {
-                if (state.callback) {
-                    has_active_fds = true;
-                    break;
-                }
-            }
+            fds_.for_each([&](int32_t, fd_state& state) { has_active_fds |= !!state.callback; });
             if (!has_active_fds) {
                 running_ = false;
                 break;
             }
             if (now >= graceful_shutdown_deadline_) {
-                for (size_t fd = 0; fd < fd_states_.size(); ++fd) {
-                    if (!fd_states_[fd].callback)
-                        continue;
+                fds_.for_each([&](int32_t fd, fd_state& state) {
+                    if (!state.callback)
+                        return;
                     try {
-                        fd_states_[fd].callback(event_type::error);
+                        state.callback(event_type::error);
                     } catch (...) {
-                        handle_exception("forced_shutdown_callback",
-                                         std::current_exception(),
-                                         static_cast<int32_t>(fd));
+                        handle_exception(
+                            "forced_shutdown_callback", std::current_exception(), fd);
                     }
-                    if (fd_states_[fd].callback) {
-                        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, static_cast<int32_t>(fd), nullptr);
-                        close(static_cast<int32_t>(fd));
-                        fd_states_[fd] = fd_state{};
+                    if (fds_.find(fd) == &state && state.callback) {
+                        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                        close(fd);
+                        fds_.erase(fd);
                     }
-                }
+                });
                 running_ = false;
                 break;
             }
         }
 
         int timeout_ms = calculate_timeout(loop_now);
-        auto res = process_events(timeout_ms);
+        auto res = timeout_ms != 0 && spin_budget_.count() > 0 ? spin_then_wait(timeout_ms)
+                                                                : process_events(timeout_ms);
         if (!res) {
             running_ = false;
-            return res;
+            return std::unexpected(res.error());
         }
 
         flush_deferred_closes();
@@ -194,20 +219,12 @@ result<void> epoll_reactor::register_fd(int32_t fd, event_type events, event_cal
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto ensure = ensure_fd_capacity(fd);
-    if (!ensure) {
-        return ensure;
-    }
-
-    epoll_event ev{};
-    ev.events = to_epoll_events(events);
-    ev.data.fd = fd;
-
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
-        return std::unexpected(std::error_code(errno, std::system_category()));
+    auto handle = add_fd(fd, events);
+    if (!handle) {
+        return std::unexpected(handle.error());
     }
 
-    auto& state = fd_states_[static_cast<size_t>(fd)];
+    auto& state = *fds_.resolve(*handle);
     state.callback = std::move(callback);
     state.events = events;
     state.timeouts = {};
@@ -228,12 +245,12 @@ result<void> epoll_reactor::register_fd_with_timeout(int32_t fd,
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto ensure = ensure_fd_capacity(fd);
-    if (!ensure) {
-        return ensure;
+    auto handle = add_fd(fd, events);
+    if (!handle) {
+        return std::unexpected(handle.error());
     }
 
-    fd_state state{};
+    auto& state = *fds_.resolve(*handle);
     state.callback = std::move(callback);
     state.events = events;
     state.timeouts = config;
@@ -241,67 +258,61 @@ result<void> epoll_reactor::register_fd_with_timeout(int32_t fd,
     state.has_timeout = true;
     state.timeout_interval = fd_timeout_for(state);
     state.last_activity = std::chrono::steady_clock::now();
-    schedule_fd_timeout(fd, state);
-
-    epoll_event ev{};
-    ev.events = to_epoll_events(events);
-    ev.data.fd = fd;
+    schedule_fd_timeout(*handle, state);
 
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
-        cancel_fd_timeout(state);
-        return std::unexpected(std::error_code(errno, std::system_category()));
-    }
-
-    fd_states_[static_cast<size_t>(fd)] = std::move(state);
     active_fds_.fetch_add(1, std::memory_order_relaxed);
     return {};
 }
 
 result<void> epoll_reactor::modify_fd(int32_t fd, event_type events) {
-    if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size() ||
-        !fd_states_[static_cast<size_t>(fd)].callback) {
+    auto* state = fds_.find(fd);
+    if (!state || !state->callback) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
     epoll_event ev{};
     ev.events = to_epoll_events(events);
-    ev.data.fd = fd;
+    ev.data.u64 = fds_.handle_of(fd);
 
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
         return std::unexpected(std::error_code(errno, std::system_category()));
     }
 
-    auto& state = fd_states_[static_cast<size_t>(fd)];
-    state.events = events;
-    if (state.has_timeout) {
-        cancel_fd_timeout(state);
-        schedule_fd_timeout(fd, state);
+    state->events = events;
+    if (state->has_timeout) {
+        cancel_fd_timeout(*state);
+        schedule_fd_timeout(ev.data.u64, *state);
     }
     return {};
 }
 
 result<void> epoll_reactor::unregister_fd(int32_t fd) {
-    if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size() ||
-        !fd_states_[static_cast<size_t>(fd)].callback) {
+    auto* state = fds_.find(fd);
+    if (!state || !state->callback) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    cancel_fd_timeout(fd_states_[static_cast<size_t>(fd)]);
+    cancel_fd_timeout(*state);
 
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) < 0) {
         return std::unexpected(std::error_code(errno, std::system_category()));
     }
 
-    fd_states_[static_cast<size_t>(fd)] = fd_state{};
+    fds_.erase(fd);
     active_fds_.fetch_sub(1, std::memory_order_relaxed);
     return {};
 }
 
+void epoll_reactor::set_fd_prefetch_hint(int32_t fd, const void* object) noexcept {
+    if (auto* state = fds_.find(fd)) {
+        state->prefetch_hint = object;
+    }
+}
+
 void epoll_reactor::refresh_fd_timeout(int32_t fd) {
-    if (fd >= 0 && static_cast<size_t>(fd) < fd_states_.size() &&
-        fd_states_[static_cast<size_t>(fd)].has_timeout) {
-        auto& state = fd_states_[static_cast<size_t>(fd)];
-        state.last_activity = std::chrono::steady_clock::now();
+    auto* state = fds_.find(fd);
+    if (state && state->has_timeout) {
+        state->last_activity = std::chrono::steady_clock::now();
     }
 }
 
@@ -311,11 +322,13 @@ bool epoll_reactor::schedule(task_fn task) {
         return false;
     }
     metrics_.tasks_scheduled.fetch_add(1, std::memory_order_relaxed);
-    uint32_t prev = pending_count_.fetch_add(1, std::memory_order_relaxed);
+    // seq_cst pairs with spin_then_wait(): either it sees this task before blocking or this
+    // sees needs_wakeup_ cleared and writes the eventfd.
+    uint32_t prev = pending_count_.fetch_add(1, std::memory_order_seq_cst);
 
     if (prev == 0) {
         bool expected = false;
-        if (needs_wakeup_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        if (needs_wakeup_.compare_exchange_strong(expected, true, std::memory_order_seq_cst)) {
             uint64_t val = 1;
             ssize_t ret;
             do {
@@ -357,68 +370,109 @@ bool epoll_reactor::schedule_after(std::chrono::milliseconds delay, task_fn task
     return true;
 }
 
-result<void> epoll_reactor::process_events(int32_t timeout_ms) {
+result<int32_t> epoll_reactor::spin_then_wait(int32_t timeout_ms) {
+    // needs_wakeup_ set means a wakeup is already pending, so producers skip the eventfd.
+    needs_wakeup_.store(true, std::memory_order_seq_cst);
+    const auto deadline = std::chrono::steady_clock::now() + spin_budget_;
+    while (running_.load(std::memory_order_relaxed)) {
+        metrics_.busy_polls.fetch_add(1, std::memory_order_relaxed);
+        auto polled = process_events(0);
+        if (!polled || *polled > 0 || pending_count_.load(std::memory_order_relaxed) > 0) {
+            if (polled && *polled > 0) {
+                metrics_.busy_poll_hits.fetch_add(1, std::memory_order_relaxed);
+            }
+            return polled;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        cpu_relax();
+    }
+
+    needs_wakeup_.store(false, std::memory_order_seq_cst);
+    if (pending_count_.load(std::memory_order_seq_cst) > 0 ||
+        !running_.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    metrics_.blocking_waits.fetch_add(1, std::memory_order_relaxed);
+    return process_events(timeout_ms);
+}
+
+result<int32_t> epoll_reactor::process_events(int32_t timeout_ms) {
     int32_t nfds = epoll_wait(epoll_fd_, events_buffer_.data(), max_events_, timeout_ms);
 
     if (nfds < 0) {
         if (errno == EINTR) {
-            return {};
+            return 0;
         }
         return std::unexpected(std::error_code(errno, std::system_category()));
     }
 
+    // Dispatch in chunks, each in phases: prefetch every event's fd state, then the objects
+    // those states point at, then run the callbacks against warm lines. The phases overlap
+    // the misses of the whole chunk instead of taking them one callback at a time.
     constexpr int32_t kChunk = 128;
     for (int32_t base = 0; base < nfds; base += kChunk) {
-        const int32_t end = std::min<int32_t>(base + kChunk, nfds);
+        const auto first = events_buffer_.begin() + base;
+        const auto last = events_buffer_.begin() + std::min<int32_t>(base + kChunk, nfds);
 
-        // Prefetch phase: warm up fd_state for this chunk.
-        for (int32_t i = base; i < end; ++i) {
-            int32_t fd = events_buffer_[static_cast<size_t>(i)].data.fd;
-            if (fd >= 0 && static_cast<size_t>(fd) < fd_states_.size()) {
-                __builtin_prefetch(&fd_states_[static_cast<size_t>(fd)], 0, 1);
-            }
+        for (auto it = first; it != last; ++it) {
+            fds_.prefetch(it->data.u64);
         }
-
-        for (int32_t i = base; i < end; ++i) {
-            int32_t fd = events_buffer_[static_cast<size_t>(i)].data.fd;
-
-            if (fd == wakeup_fd_) {
-                uint64_t val;
-                ssize_t ret = read(wakeup_fd_, &val, sizeof(val));
-                (void)ret;
-                needs_wakeup_.store(true, std::memory_order_relaxed);
-                continue;
+        for (auto it = first; it != last; ++it) {
+            auto* state = fds_.resolve(it->data.u64);
+            if (state && state->prefetch_hint) {
+                __builtin_prefetch(state->prefetch_hint, 0, 1);
             }
+        }
 
-            if (fd >= 0 && static_cast<size_t>(fd) < fd_states_.size() &&
-                fd_states_[static_cast<size_t>(fd)].callback) {
-                event_type ev = from_epoll_events(events_buffer_[static_cast<size_t>(i)].events);
-                auto& state = fd_states_[static_cast<size_t>(fd)];
-
-                if (i + 1 < end) {
-                    int32_t next_fd = events_buffer_[static_cast<size_t>(i + 1)].data.fd;
-                    if (next_fd >= 0 && static_cast<size_t>(next_fd) < fd_states_.size()) {
-                        __builtin_prefetch(&fd_states_[static_cast<size_t>(next_fd)], 0, 1);
-                    }
-                }
-                if (i + 2 < end && (end - base) >= 16) {
-                    int32_t next_fd2 = events_buffer_[static_cast<size_t>(i + 2)].data.fd;
-                    if (next_fd2 >= 0 && static_cast<size_t>(next_fd2) < fd_states_.size()) {
-                        __builtin_prefetch(&fd_states_[static_cast<size_t>(next_fd2)], 0, 1);
-                    }
+        if (writable_first_) {
+            // Two passes rather than a sort: no reordering of the buffer, and an event with
+            // both directions ready still runs once.
+            for (auto it = first; it != last; ++it) {
+                if (it->events & EPOLLOUT) {
+                    dispatch_event(*it);
                 }
-
-                try {
-                    state.callback(ev);
-                    metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
-                } catch (...) {
-                    handle_exception("fd_callback", std::current_exception(), fd);
+            }
+            for (auto it = first; it != last; ++it) {
+                if (!(it->events & EPOLLOUT)) {
+                    dispatch_event(*it);
                 }
             }
+        } else {
+            for (auto it = first; it != last; ++it) {
+                dispatch_event(*it);
+            }
         }
     }
 
-    return {};
+    return nfds;
+}
+
+void epoll_reactor::dispatch_event(const epoll_event& event) {
+    const uint64_t handle = event.data.u64;
+    if (handle == WAKEUP_HANDLE) {
+        uint64_t val;
+        ssize_t ret = read(wakeup_fd_, &val, sizeof(val));
+        (void)ret;
+        needs_wakeup_.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    // A stale handle means the fd was closed (and maybe reused) by an earlier callback in this
+    // batch; the event belonged to the old registration.
+    auto* state = fds_.resolve(handle);
+    if (!state || !state->callback) {
+        return;
+    }
+
+    const int32_t fd = fds_.fd_of(handle);
+    try {
+        state->callback(from_epoll_events(event.events));
+        metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("fd_callback", std::current_exception(), fd);
+    }
 }
 
 void epoll_reactor::process_tasks() {
@@ -440,20 +494,20 @@ void epoll_reactor::process_tasks() {
 
 void epoll_reactor::process_timers(std::chrono::steady_clock::time_point now) {
     while (auto timer = pending_timers_.pop()) {
-        timers_.push(std::move(*timer));
+        wheel_timer_.add_at(timer->deadline, [this, task = std::move(timer->task)]() {
+            run_delayed_task(task);
+        });
     }
+    wheel_timer_.tick(now);
+}
 
-    while (!timers_.empty() && timers_.top().deadline <= now) {
-        auto task = std::move(timers_.top().task);
-        timers_.pop();
-
-        try {
-            task();
-            metrics_.tasks_executed.fetch_add(1, std::memory_order_relaxed);
-            metrics_.timers_fired.fetch_add(1, std::memory_order_relaxed);
-        } catch (...) {
-            handle_exception("delayed_task", std::current_exception());
-        }
+void epoll_reactor::run_delayed_task(const task_fn& task) {
+    try {
+        task();
+        metrics_.tasks_executed.fetch_add(1, std::memory_order_relaxed);
+        metrics_.timers_fired.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("delayed_task", std::current_exception());
     }
 }
 
@@ -473,16 +527,6 @@ int32_t epoll_reactor::calculate_timeout(std::chrono::steady_clock::time_point n
 
     auto min_timeout = std::chrono::milliseconds::max();
 
-    if (!timers_.empty()) {
-        auto deadline = timers_.top().deadline;
-        if (deadline <= now) {
-            timeout_dirty_.store(true, std::memory_order_relaxed);
-            return 0;
-        }
-        auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
-        min_timeout = std::min(min_timeout, delta);
-    }
-
     auto wheel_timeout = wheel_timer_.time_until_next_expiration(now);
     if (wheel_timeout == std::chrono::milliseconds::zero()) {
         timeout_dirty_.store(true, std::memory_order_relaxed);
@@ -529,27 +573,21 @@ uint64_t epoll_reactor::get_load_score() const noexcept {
     return active_fds * 100 + pending_tasks * 50 + pending_timers_count * 10;
 }
 
-void epoll_reactor::process_wheel_timer() {
-    wheel_timer_.tick();
-}
-
-void epoll_reactor::schedule_fd_timeout(int32_t fd, fd_state& state) {
+void epoll_reactor::schedule_fd_timeout(uint64_t handle, fd_state& state) {
     state.timeout_interval = fd_timeout_for(state);
     state.last_activity = std::chrono::steady_clock::now();
     state.timeout_id =
-        wheel_timer_.add(state.timeout_interval, [this, fd]() { handle_fd_timeout(fd); });
+        wheel_timer_.add(state.timeout_interval, [this, handle]() { handle_fd_timeout(handle); });
 }
 
-void epoll_reactor::handle_fd_timeout(int32_t fd) {
-    if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size()) {
+void epoll_reactor::handle_fd_timeout(uint64_t handle) {
+    auto* state = fds_.resolve(handle);
+    if (!state || !state->callback || !state->has_timeout) {
         return;
     }
 
-    auto index = static_cast<size_t>(fd);
-    auto& entry_state = fd_states_[index];
-    if (!entry_state.callback || !entry_state.has_timeout) {
-        return;
-    }
+    const int32_t fd = fds_.fd_of(handle);
+    auto& entry_state = *state;
 
     const auto now = std::chrono::steady_clock::now();
     const auto elapsed_ns =
@@ -577,7 +615,7 @@ void epoll_reactor::handle_fd_timeout(int32_t fd) {
 
     const auto remaining_ns = entry_state.timeout_interval.count() - elapsed_ns;
     entry_state.timeout_id = wheel_timer_.add(std::chrono::milliseconds(remaining_ns / 1'000'000),
-                                              [this, fd]() { handle_fd_timeout(fd); });
+                                              [this, handle]() { handle_fd_timeout(handle); });
 }
 
 void epoll_reactor::cancel_fd_timeout(fd_state& state) {
@@ -618,10 +656,7 @@ void epoll_reactor::close_fd_immediate(int32_t fd) {
     (void)epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
     (void)close(fd);
 
-    size_t idx = static_cast<size_t>(fd);
-    if (idx < fd_states_.size()) {
-        fd_states_[idx] = fd_state{};
-    }
+    fds_.erase(fd);
     active_fds_.fetch_sub(1, std::memory_order_relaxed);
 }
 
@@ -651,10 +686,7 @@ void epoll_reactor::flush_deferred_closes() {
                              fd);
         }
 
-        size_t idx = static_cast<size_t>(fd);
-        if (idx < fd_states_.size()) {
-            fd_states_[idx] = fd_state{};
-        }
+        fds_.erase(fd);
         active_fds_.fetch_sub(1, std::memory_order_relaxed);
     }
 }
@@ -677,32 +709,37 @@ std::chrono::milliseconds epoll_reactor::fd_timeout_for(const fd_state& state) c
     return timeout;
 }
 
-result<void> epoll_reactor::ensure_fd_capacity(int32_t fd) {
-    if (fd < 0) {
-        return std::unexpected(make_error_code(error_code::invalid_fd));
-    }
-
-    size_t index = static_cast<size_t>(fd);
-    if (index < fd_states_.size()) {
-        return {};
-    }
+result<uint64_t> epoll_reactor::add_fd(int32_t fd, event_type events) {
+    epoll_event ev{};
+    ev.events = to_epoll_events(events);
 
-    size_t new_size = fd_states_.empty() ? 64 : fd_states_.size();
-    while (new_size <= index) {
-        if (new_size > fd_states_.max_size() / 2) {
-            new_size = index + 1;
-            break;
+    // An entry left behind by an fd closed without unregister_fd: the kernel already forgot
+    // it, so add first (still under the stale handle) and only then drop the old state.
+    const bool stale_entry = fds_.find(fd) != nullptr;
+    if (stale_entry) {
+        ev.data.u64 = fds_.handle_of(fd);
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            return std::unexpected(std::error_code(errno, std::system_category()));
         }
-        new_size = std::max(new_size * 2, index + 1);
     }
 
+    uint64_t handle = 0;
     try {
-        fd_states_.resize(new_size);
+        handle = fds_.insert(fd);
     } catch (const std::bad_alloc&) {
+        if (stale_entry) {
+            (void)epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        }
         return std::unexpected(std::make_error_code(std::errc::not_enough_memory));
     }
 
-    return {};
+    ev.data.u64 = handle;
+    if (epoll_ctl(epoll_fd_, stale_entry ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) < 0) {
+        auto ec = std::error_code(errno, std::system_category());
+        fds_.erase(fd);
+        return std::unexpected(ec);
+    }
+    return handle;
 }
 
 std::chrono::milliseconds
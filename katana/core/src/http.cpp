@@ -1,10 +1,12 @@
 #include "katana/core/http.hpp"
+#include "katana/core/buffer_pool.hpp"
 #include "katana/core/simd_utils.hpp"
 
 #include <algorithm>
 #include <cctype>
 #include <charconv>
 #include <cstring>
+#include <utility>
 
 namespace katana::http {
 
@@ -29,16 +31,6 @@ alignas(64) static const bool TOKEN_CHARS[256] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
-alignas(64) static const bool INVALID_HEADER_CHARS[256] = {
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
-
 inline bool is_token_char(unsigned char c) noexcept {
     return TOKEN_CHARS[c];
 }
@@ -57,15 +49,6 @@ std::string_view trim_ows(std::string_view value) noexcept {
     return value;
 }
 
-bool contains_invalid_header_value(std::string_view value) noexcept {
-    for (char ch : value) {
-        if (INVALID_HEADER_CHARS[static_cast<unsigned char>(ch)]) {
-            return true;
-        }
-    }
-    return false;
-}
-
 bool contains_invalid_uri_char(std::string_view uri) noexcept {
     for (char ch : uri) {
         auto c = static_cast<unsigned char>(ch);
@@ -132,13 +115,22 @@ void response::serialize_into(std::string& out) const {
         return;
     }
 
+    out.clear();
+    append_head(out, body.size());
+    out.append(body);
+}
+
+void response::append_head_to(std::string& out) const {
+    append_head(out, 0);
+}
+
+void response::append_head(std::string& out, size_t reserve_extra) const {
     size_t headers_size = 0;
     for (const auto& [name, value] : headers) {
         headers_size += name.size() + HEADER_SEPARATOR.size() + value.size() + CRLF.size();
     }
 
-    out.clear();
-    out.reserve(32 + reason.size() + headers_size + body.size());
+    out.reserve(out.size() + 32 + reason.size() + headers_size + reserve_extra);
 
     char status_buf[16];
     auto [ptr, ec] = std::to_chars(status_buf, status_buf + sizeof(status_buf), status);
@@ -157,7 +149,6 @@ void response::serialize_into(std::string& out) const {
     }
 
     out.append(CRLF);
-    out.append(body);
 }
 
 std::string response::serialize_chunked(size_t chunk_size) const {
@@ -237,9 +228,127 @@ response response::error(const problem_details& problem) {
     return res;
 }
 
+parser::~parser() {
+    release_buffer();
+    release_chunked_body();
+}
+
+parser::parser(parser&& other) noexcept
+    : arena_(other.arena_), state_(other.state_), request_(std::move(other.request_)),
+      storage_(std::exchange(other.storage_, nullptr)),
+      storage_capacity_(std::exchange(other.storage_capacity_, 0)),
+      buffer_(std::exchange(other.buffer_, nullptr)),
+      buffer_size_(std::exchange(other.buffer_size_, 0)),
+      chunked_body_(std::exchange(other.chunked_body_, nullptr)),
+      chunked_body_size_(std::exchange(other.chunked_body_size_, 0)),
+      chunked_body_capacity_(std::exchange(other.chunked_body_capacity_, 0)),
+      last_header_field_(other.last_header_field_), last_header_name_(other.last_header_name_),
+      last_header_name_len_(other.last_header_name_len_), parse_pos_(other.parse_pos_),
+      scan_pos_(other.scan_pos_), line_colon_(other.line_colon_),
+      content_length_(other.content_length_), current_chunk_size_(other.current_chunk_size_),
+      header_count_(other.header_count_), is_chunked_(other.is_chunked_),
+      in_place_(other.in_place_) {}
+
+parser& parser::operator=(parser&& other) noexcept {
+    if (this != &other) {
+        release_buffer();
+        release_chunked_body();
+        arena_ = other.arena_;
+        state_ = other.state_;
+        request_ = std::move(other.request_);
+        storage_ = std::exchange(other.storage_, nullptr);
+        storage_capacity_ = std::exchange(other.storage_capacity_, 0);
+        buffer_ = std::exchange(other.buffer_, nullptr);
+        buffer_size_ = std::exchange(other.buffer_size_, 0);
+        chunked_body_ = std::exchange(other.chunked_body_, nullptr);
+        chunked_body_size_ = std::exchange(other.chunked_body_size_, 0);
+        chunked_body_capacity_ = std::exchange(other.chunked_body_capacity_, 0);
+        last_header_field_ = other.last_header_field_;
+        last_header_name_ = other.last_header_name_;
+        last_header_name_len_ = other.last_header_name_len_;
+        parse_pos_ = other.parse_pos_;
+        scan_pos_ = other.scan_pos_;
+        line_colon_ = other.line_colon_;
+        content_length_ = other.content_length_;
+        current_chunk_size_ = other.current_chunk_size_;
+        header_count_ = other.header_count_;
+        is_chunked_ = other.is_chunked_;
+        in_place_ = other.in_place_;
+    }
+    return *this;
+}
+
+bool parser::reserve_buffer(size_t size) noexcept {
+    if (size <= storage_capacity_) {
+        return true;
+    }
+    if (size > MAX_BUFFER_SIZE) {
+        return false;
+    }
+
+    size_t capacity = buffer_pool::block_size_for(std::max(size, storage_capacity_ * 2));
+    uint8_t* block = buffer_pool::local().acquire(capacity);
+    if (!block) {
+        return false;
+    }
+
+    char* grown = static_cast<char*>(static_cast<void*>(block));
+    if (buffer_size_ > 0) {
+        std::memcpy(grown, storage_, buffer_size_);
+    }
+    release_buffer();
+    storage_ = grown;
+    storage_capacity_ = capacity;
+    buffer_ = storage_;
+    return true;
+}
+
+void parser::release_buffer() noexcept {
+    if (storage_) {
+        buffer_pool::local().release(static_cast<uint8_t*>(static_cast<void*>(storage_)),
+                                     storage_capacity_);
+        storage_ = nullptr;
+        storage_capacity_ = 0;
+    }
+}
+
+// The chunked body grows geometrically in buffer_pool blocks, each handed back as soon as it
+// is outgrown; the arena would pin every intermediate copy until the connection's next reset.
+bool parser::reserve_chunked_body(size_t size) noexcept {
+    if (size <= chunked_body_capacity_) {
+        return true;
+    }
+
+    size_t capacity = buffer_pool::block_size_for(std::max(size, chunked_body_capacity_ * 2));
+    uint8_t* block = buffer_pool::local().acquire(capacity);
+    if (!block) {
+        return false;
+    }
+
+    char* grown = static_cast<char*>(static_cast<void*>(block));
+    if (chunked_body_size_ > 0) {
+        std::memcpy(grown, chunked_body_, chunked_body_size_);
+    }
+    size_t body_size = chunked_body_size_;
+    release_chunked_body();
+    chunked_body_ = grown;
+    chunked_body_size_ = body_size;
+    chunked_body_capacity_ = capacity;
+    return true;
+}
+
+void parser::release_chunked_body() noexcept {
+    if (chunked_body_) {
+        buffer_pool::local().release(static_cast<uint8_t*>(static_cast<void*>(chunked_body_)),
+                                     chunked_body_capacity_);
+        chunked_body_ = nullptr;
+        chunked_body_size_ = 0;
+        chunked_body_capacity_ = 0;
+    }
+}
+
 result<parser::state> parser::parse(std::span<const uint8_t> data) {
-    if (!buffer_ || data.size() > buffer_capacity_ || buffer_size_ > buffer_capacity_ - data.size())
-        [[unlikely]] {
+    if (!arena_ || in_place_ || data.size() > MAX_BUFFER_SIZE - buffer_size_) [[unlikely]] {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
@@ -247,47 +356,52 @@ result<parser::state> parser::parse(std::span<const uint8_t> data) {
         return state_;
     }
 
-    if (state_ == state::request_line || state_ == state::headers) [[likely]] {
-        for (size_t i = 0; i < data.size(); ++i) {
-            uint8_t byte = data[i];
-            if (byte == 0 || byte >= 0x80) [[unlikely]] {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-            if (byte == '\n') [[unlikely]] {
-                size_t buf_pos = buffer_size_ + i;
-                if (buf_pos == 0 ||
-                    (buf_pos > 0 &&
-                     (buf_pos - 1 < buffer_size_ ? buffer_[buf_pos - 1] : data[i - 1]) != '\r')) {
-                    return std::unexpected(make_error_code(error_code::invalid_fd));
-                }
-            }
-        }
+    if (!reserve_buffer(std::max(buffer_size_ + data.size(), INITIAL_BUFFER_SIZE))) [[unlikely]] {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    std::memcpy(buffer_ + buffer_size_, data.data(), data.size());
+    std::memcpy(storage_ + buffer_size_, data.data(), data.size());
     buffer_size_ += data.size();
+    return run();
+}
 
-    if (state_ != state::body && state_ != state::chunk_data) {
-        if (buffer_size_ > MAX_HEADER_SIZE) {
-            const char* header_end = std::strstr(buffer_, "\r\n\r\n");
-            if (!header_end || static_cast<size_t>(header_end - buffer_) + 4 > MAX_HEADER_SIZE) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-        }
+result<parser::state> parser::parse_in_place(std::span<const uint8_t> data) {
+    if (!arena_) [[unlikely]] {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
 
-        size_t crlf_pairs = 0;
-        for (size_t i = 0; i + 1 < buffer_size_; ++i) {
-            if (buffer_[i] == '\r' && buffer_[i + 1] == '\n') {
-                ++crlf_pairs;
-            }
-        }
-        if (crlf_pairs > MAX_HEADER_COUNT + 2) {
+    const char* input = static_cast<const char*>(static_cast<const void*>(data.data()));
+    if (!in_place_) {
+        if (buffer_size_ > 0) {
             return std::unexpected(make_error_code(error_code::invalid_fd));
         }
-    } else if (buffer_size_ > MAX_HEADER_SIZE + MAX_BODY_SIZE) {
+        release_buffer();
+        in_place_ = true;
+    } else if (input != buffer_ || data.size() < buffer_size_) {
+        // The caller's buffer moved or was consumed: views taken so far are stale.
+        restart();
+    }
+
+    buffer_ = input;
+    if (data.size() == buffer_size_) {
+        return state_;
+    }
+
+    buffer_size_ = data.size();
+    auto next = run();
+    if (!next) {
+        return next;
+    }
+    // `data` may run on into pipelined requests, so the limit applies to this request: all
+    // of the buffer until it completes, then the bytes it spans.
+    const size_t extent = *next == state::complete ? parse_pos_ : buffer_size_;
+    if (extent > MAX_BUFFER_SIZE) [[unlikely]] {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
+    return next;
+}
 
+result<parser::state> parser::run() {
     while (state_ != state::complete) {
         size_t old_parse_pos = parse_pos_;
         result<state> next_state = [&]() -> result<state> {
@@ -316,150 +430,147 @@ result<parser::state> parser::parse(std::span<const uint8_t> data) {
         state_ = *next_state;
 
         if (parse_pos_ == old_parse_pos && state_ != state::complete) {
-            if (parse_pos_ > COMPACT_THRESHOLD || buffer_size_ > MAX_HEADER_SIZE * 2) {
+            // The head is never compacted: its line scan resumes at scan_pos_ and the
+            // MAX_HEADER_SIZE check needs offsets from the start of the request.
+            if (!in_place_ && state_ != state::request_line && state_ != state::headers &&
+                (parse_pos_ > COMPACT_THRESHOLD || buffer_size_ > MAX_HEADER_SIZE * 2)) {
                 compact_buffer();
             }
             return state_;
         }
     }
 
-    if (parse_pos_ > COMPACT_THRESHOLD || buffer_size_ > MAX_HEADER_SIZE * 2) {
-        compact_buffer();
-    }
-
+    // No compaction once complete: bytes_parsed() must keep pointing past this request.
     return state_;
 }
 
-result<parser::state> parser::parse_request_line_state() {
-    const char* found = simd::find_crlf(buffer_ + parse_pos_, buffer_size_ - parse_pos_);
-
-    if (found) {
-        size_t pos = static_cast<size_t>(found - buffer_);
-        for (size_t i = parse_pos_; i <= pos; ++i) {
-            unsigned char c = static_cast<unsigned char>(buffer_[i]);
-            if (c == '\0' || c >= 0x80) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-            if (c == '\n' && (i == 0 || buffer_[i - 1] != '\r')) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-        }
+// Lines of the head are scanned once: a partial line is resumed at scan_pos_ when more bytes
+// arrive, so slowly arriving headers cost linear time overall.
+result<std::optional<parser::head_line>> parser::next_head_line() {
+    auto scan = simd::scan_http_line(buffer_ + scan_pos_, buffer_size_ - scan_pos_);
+    if (line_colon_ == SIZE_MAX && scan.colon != SIZE_MAX) {
+        line_colon_ = scan_pos_ + scan.colon;
+    }
 
-        std::string_view line(buffer_ + parse_pos_, pos - parse_pos_);
-        parse_pos_ = pos + 2;
+    size_t end = scan_pos_ + scan.end;
+    if (scan.result == simd::line_scan::status::invalid || end + 2 > MAX_HEADER_SIZE) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+    if (scan.result == simd::line_scan::status::incomplete) {
+        scan_pos_ = end;
+        return std::nullopt;
+    }
 
-        auto res = process_request_line(line);
-        if (!res) {
-            return std::unexpected(res.error());
-        }
+    head_line line{std::string_view(buffer_ + parse_pos_, end - parse_pos_),
+                   line_colon_ == SIZE_MAX ? std::string_view::npos : line_colon_ - parse_pos_};
+    parse_pos_ = end + 2;
+    scan_pos_ = parse_pos_;
+    line_colon_ = SIZE_MAX;
+    return line;
+}
 
-        return state::headers;
+result<parser::state> parser::parse_request_line_state() {
+    auto line = next_head_line();
+    if (!line) {
+        return std::unexpected(line.error());
+    }
+    if (!*line) {
+        return state::request_line;
     }
 
-    return state::request_line;
+    auto res = process_request_line((*line)->text);
+    if (!res) {
+        return std::unexpected(res.error());
+    }
+    return state::headers;
 }
 
 result<parser::state> parser::parse_headers_state() {
-    const char* found = simd::find_crlf(buffer_ + parse_pos_, buffer_size_ - parse_pos_);
+    auto next = next_head_line();
+    if (!next) {
+        return std::unexpected(next.error());
+    }
+    if (!*next) {
+        return state::headers;
+    }
 
-    if (found) {
-        size_t pos = static_cast<size_t>(found - buffer_);
-        for (size_t i = parse_pos_; i <= pos; ++i) {
-            unsigned char c = static_cast<unsigned char>(buffer_[i]);
-            if (c == '\0' || c >= 0x80) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
+    std::string_view line = (*next)->text;
+    if (line.empty()) {
+        auto te = request_.headers.get(field::transfer_encoding);
+        if (te && ci_equal(*te, "chunked")) {
+            is_chunked_ = true;
+            return state::chunk_size;
+        }
+
+        auto cl = request_.headers.get(field::content_length);
+        if (cl) {
+            std::string_view cl_view = *cl;
+            while (!cl_view.empty() && (cl_view.back() == ' ' || cl_view.back() == '\t')) {
+                cl_view.remove_suffix(1);
             }
-            if (c == '\n' && (i == 0 || buffer_[i - 1] != '\r')) {
+
+            unsigned long long val = 0;
+            auto [ptr, ec] = std::from_chars(cl_view.data(), cl_view.data() + cl_view.size(), val);
+            if (ec != std::errc() || ptr != cl_view.data() + cl_view.size() || val > SIZE_MAX ||
+                val > MAX_BODY_SIZE) {
                 return std::unexpected(make_error_code(error_code::invalid_fd));
             }
+            content_length_ = static_cast<size_t>(val);
+            return state::body;
         }
 
-        std::string_view line(buffer_ + parse_pos_, pos - parse_pos_);
-        parse_pos_ = pos + 2;
-
-        if (line.empty()) {
-            auto te = request_.headers.get(field::transfer_encoding);
-            if (te && ci_equal(*te, "chunked")) {
-                is_chunked_ = true;
-                return state::chunk_size;
-            }
+        return state::complete;
+    }
 
-            auto cl = request_.headers.get(field::content_length);
-            if (cl) {
-                std::string_view cl_view = *cl;
-                while (!cl_view.empty() && (cl_view.back() == ' ' || cl_view.back() == '\t')) {
-                    cl_view.remove_suffix(1);
-                }
-
-                unsigned long long val = 0;
-                auto [ptr, ec] =
-                    std::from_chars(cl_view.data(), cl_view.data() + cl_view.size(), val);
-                if (ec != std::errc() || ptr != cl_view.data() + cl_view.size() || val > SIZE_MAX ||
-                    val > MAX_BODY_SIZE) {
-                    return std::unexpected(make_error_code(error_code::invalid_fd));
-                }
-                content_length_ = static_cast<size_t>(val);
-                return state::body;
-            }
+    if (line.front() == ' ' || line.front() == '\t') {
+        if (!last_header_name_) {
+            return std::unexpected(make_error_code(error_code::invalid_fd));
+        }
 
-            return state::complete;
+        // Get current value using either field enum or name
+        std::optional<std::string_view> current_value;
+        if (last_header_field_ != field::unknown) {
+            current_value = request_.headers.get(last_header_field_);
+        } else {
+            current_value = request_.headers.get(
+                std::string_view(last_header_name_, last_header_name_len_));
         }
 
-        if (line.front() == ' ' || line.front() == '\t') {
-            if (!last_header_name_) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
+        if (!current_value) {
+            return std::unexpected(make_error_code(error_code::invalid_fd));
+        }
 
-            // Get current value using either field enum or name
-            std::optional<std::string_view> current_value;
+        // Header folding - allocate combined value in arena
+        auto folded_view = std::string_view(line);
+        while (!folded_view.empty() &&
+               (folded_view.front() == ' ' || folded_view.front() == '\t')) {
+            folded_view.remove_prefix(1);
+        }
+        folded_view = trim_ows(folded_view);
+
+        size_t total_len = current_value->size() + 1 + folded_view.size();
+        char* combined = static_cast<char*>(arena_->allocate(total_len + 1, 1));
+        if (combined) {
+            std::memcpy(combined, current_value->data(), current_value->size());
+            combined[current_value->size()] = ' ';
+            std::memcpy(
+                combined + current_value->size() + 1, folded_view.data(), folded_view.size());
+            combined[total_len] = '\0';
+
+            // Set using either field enum or name
             if (last_header_field_ != field::unknown) {
-                current_value = request_.headers.get(last_header_field_);
+                request_.headers.set(last_header_field_, std::string_view(combined, total_len));
             } else {
-                current_value = request_.headers.get(
-                    std::string_view(last_header_name_, last_header_name_len_));
-            }
-
-            if (!current_value) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-
-            // Header folding - allocate combined value in arena
-            auto folded_view = std::string_view(line);
-            while (!folded_view.empty() &&
-                   (folded_view.front() == ' ' || folded_view.front() == '\t')) {
-                folded_view.remove_prefix(1);
-            }
-            folded_view = trim_ows(folded_view);
-            if (contains_invalid_header_value(folded_view)) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
-
-            size_t total_len = current_value->size() + 1 + folded_view.size();
-            char* combined = static_cast<char*>(arena_->allocate(total_len + 1, 1));
-            if (combined) {
-                std::memcpy(combined, current_value->data(), current_value->size());
-                combined[current_value->size()] = ' ';
-                std::memcpy(
-                    combined + current_value->size() + 1, folded_view.data(), folded_view.size());
-                combined[total_len] = '\0';
-
-                // Set using either field enum or name
-                if (last_header_field_ != field::unknown) {
-                    request_.headers.set(last_header_field_, std::string_view(combined, total_len));
-                } else {
-                    request_.headers.set_view(
-                        std::string_view(last_header_name_, last_header_name_len_),
-                        std::string_view(combined, total_len));
-                }
-            }
-        } else {
-            auto res = process_header_line(line);
-            if (!res) {
-                return std::unexpected(res.error());
+                request_.headers.set_view(
+                    std::string_view(last_header_name_, last_header_name_len_),
+                    std::string_view(combined, total_len));
             }
         }
-
-        return state::headers;
+    } else {
+        auto res = process_header_line(line, (*next)->colon);
+        if (!res) {
+            return std::unexpected(res.error());
+        }
     }
 
     return state::headers;
@@ -468,9 +579,9 @@ result<parser::state> parser::parse_headers_state() {
 result<parser::state> parser::parse_body_state() {
     size_t remaining = buffer_size_ - parse_pos_;
     if (remaining >= content_length_) {
-        char* body_ptr =
-            arena_->allocate_string(std::string_view(buffer_ + parse_pos_, content_length_));
-        request_.body = std::string_view(body_ptr, content_length_);
+        std::string_view body(buffer_ + parse_pos_, content_length_);
+        request_.body =
+            in_place_ ? body : std::string_view(arena_->allocate_string(body), body.size());
         parse_pos_ += content_length_;
         return state::complete;
     }
@@ -526,11 +637,8 @@ result<parser::state> parser::parse_chunk_data_state() {
             return std::unexpected(make_error_code(error_code::invalid_fd));
         }
 
-        if (!chunked_body_) {
-            chunked_body_ = static_cast<char*>(arena_->allocate(MAX_BODY_SIZE, 1));
-            if (!chunked_body_) {
-                return std::unexpected(make_error_code(error_code::invalid_fd));
-            }
+        if (!reserve_chunked_body(chunked_body_size_ + current_chunk_size_)) {
+            return std::unexpected(make_error_code(error_code::invalid_fd));
         }
 
         std::memcpy(chunked_body_ + chunked_body_size_, chunk_start, current_chunk_size_);
@@ -585,8 +693,7 @@ result<void> parser::process_request_line(std::string_view line) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    char* uri_ptr = arena_->allocate_string(uri);
-    request_.uri = std::string_view(uri_ptr, uri.size());
+    request_.uri = in_place_ ? uri : std::string_view(arena_->allocate_string(uri), uri.size());
 
     auto version = line.substr(uri_end + 1);
     if (version != "HTTP/1.1") {
@@ -596,12 +703,11 @@ result<void> parser::process_request_line(std::string_view line) {
     return {};
 }
 
-result<void> parser::process_header_line(std::string_view line) {
+result<void> parser::process_header_line(std::string_view line, size_t colon) {
     if (header_count_ >= MAX_HEADER_COUNT) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto colon = line.find(':');
     if (colon == std::string_view::npos) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
@@ -621,9 +727,6 @@ result<void> parser::process_header_line(std::string_view line) {
     }
 
     value = trim_ows(value);
-    if (contains_invalid_header_value(value)) {
-        return std::unexpected(make_error_code(error_code::invalid_fd));
-    }
 
     last_header_field_ = field::unknown;
     last_header_name_ = nullptr;
@@ -631,7 +734,7 @@ result<void> parser::process_header_line(std::string_view line) {
 
     if (name.size() == 4 && (name[0] == 'H' || name[0] == 'h')) {
         if (ci_equal_fast(name, "Host")) {
-            request_.headers.set_known(field::host, value);
+            store_header(field::host, value);
             last_header_field_ = field::host;
             ++header_count_;
             return {};
@@ -640,7 +743,7 @@ result<void> parser::process_header_line(std::string_view line) {
 
     if (name.size() == 14 && (name[0] == 'C' || name[0] == 'c')) {
         if (ci_equal_fast(name, "Content-Length")) {
-            request_.headers.set_known(field::content_length, value);
+            store_header(field::content_length, value);
 
             unsigned long long len = 0;
             auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), len);
@@ -657,24 +760,37 @@ result<void> parser::process_header_line(std::string_view line) {
     last_header_field_ = string_to_field(name);
 
     if (last_header_field_ != field::unknown) {
-        request_.headers.set_known(last_header_field_, value);
+        store_header(last_header_field_, value);
         ++header_count_;
         return {};
     }
 
-    last_header_name_ = arena_->allocate_string(name);
+    if (in_place_) {
+        last_header_name_ = name.data();
+        request_.headers.borrow_unknown(name, value);
+    } else {
+        last_header_name_ = arena_->allocate_string(name);
+        request_.headers.set_unknown(name, value);
+    }
     last_header_name_len_ = name.size();
-    request_.headers.set_unknown(name, value);
     ++header_count_;
     return {};
 }
 
+void parser::store_header(field f, std::string_view value) noexcept {
+    if (in_place_) {
+        request_.headers.borrow_known(f, value);
+    } else {
+        request_.headers.set_known(f, value);
+    }
+}
+
 void parser::compact_buffer() {
     if (parse_pos_ >= buffer_size_) {
         buffer_size_ = 0;
         parse_pos_ = 0;
     } else if (parse_pos_ > COMPACT_THRESHOLD / 2) {
-        std::memmove(buffer_, buffer_ + parse_pos_, buffer_size_ - parse_pos_);
+        std::memmove(storage_, storage_ + parse_pos_, buffer_size_ - parse_pos_);
         buffer_size_ -= parse_pos_;
         parse_pos_ = 0;
     }
@@ -682,29 +798,31 @@ void parser::compact_buffer() {
 
 void parser::reset(monotonic_arena* arena) noexcept {
     arena_ = arena;
+    restart();
+    release_buffer();
+    release_chunked_body();
+    buffer_ = nullptr;
+    in_place_ = false;
+}
+
+void parser::restart() noexcept {
     state_ = state::request_line;
     request_.http_method = method::unknown;
     request_.uri = {};
     request_.body = {};
     request_.headers.reset(arena_);
     buffer_size_ = 0;
-    buffer_capacity_ = 0;
     parse_pos_ = 0;
+    scan_pos_ = 0;
+    line_colon_ = SIZE_MAX;
     content_length_ = 0;
     current_chunk_size_ = 0;
     header_count_ = 0;
     is_chunked_ = false;
-    chunked_body_ = nullptr;
     chunked_body_size_ = 0;
     last_header_field_ = field::unknown;
     last_header_name_ = nullptr;
     last_header_name_len_ = 0;
-    if (arena_) {
-        buffer_ = static_cast<char*>(arena_->allocate(MAX_BUFFER_SIZE, 1));
-        buffer_capacity_ = MAX_BUFFER_SIZE;
-    } else {
-        buffer_ = nullptr;
-    }
 }
 
 } // namespace katana::http
@@ -8,182 +8,440 @@
 namespace katana {
 namespace http {
 
-void server::handle_connection(connection_state& state, [[maybe_unused]] reactor& r) {
-    if (!state.write_buffer.empty()) {
-        while (!state.write_buffer.empty()) {
-            auto data = state.write_buffer.readable_span();
-            auto write_result = state.socket.write(data);
-
-            if (!write_result) {
-                if (write_result.error().value() == EAGAIN ||
-                    write_result.error().value() == EWOULDBLOCK) {
-                    return;
-                }
-                state.watch.reset();
-                return;
-            }
+server::request_status server::process_request(connection_state& state,
+                                               size_t zerocopy_threshold) {
+    // The parser sees the whole unconsumed read buffer each time and resumes where the last
+    // read left off, so a head or body arriving in small pieces is scanned once; it and the
+    // arena are reset only once a request has been answered. bytes_parsed() is an offset into
+    // the buffer. The request is parsed in place, so its views point into read_buffer:
+    // nothing may be consumed from the buffer until the response has been queued, which
+    // copies or owns everything it sends.
+    auto parse_result = state.http_parser.parse_in_place(state.read_buffer.readable_span());
+    if (!parse_result) {
+        auto resp = response::error(problem_details::bad_request("Invalid HTTP request"));
+        resp.set_header("Connection", "close");
+        queue_response(state, resp, zerocopy_threshold);
+        return request_status::respond_and_close;
+    }
 
-            if (write_result.value() == 0) {
-                break;
-            }
+    if (!state.http_parser.is_complete()) {
+        return request_status::incomplete;
+    }
+
+    const auto& req = state.http_parser.get_request();
+    request_context ctx{state.arena};
+    auto resp = hot_route_cache_ ? dispatch_or_problem(router_, req, ctx, route_cache::local())
+                                 : dispatch_or_problem(router_, req, ctx);
+
+    if (on_request_callback_) {
+        on_request_callback_(req, resp);
+    }
+
+    auto connection_header = req.headers.get("Connection");
+    bool close_connection =
+        connection_header && (*connection_header == "close" || *connection_header == "Close");
+
+    if (!resp.headers.get("Connection")) {
+        resp.set_header("Connection", close_connection ? "close" : "keep-alive");
+    }
+
+    queue_response(state, resp, zerocopy_threshold);
+    state.read_buffer.consume(state.http_parser.bytes_parsed());
+    state.http_parser.reset(&state.arena);
+    state.arena.reset();
+
+    return close_connection ? request_status::respond_and_close : request_status::respond;
+}
+
+server::request_status server::process_pipelined(connection_state& state,
+                                                 size_t zerocopy_threshold) {
+    // Every complete request already buffered is answered before anything is written, so a
+    // pipelined batch costs one vectored write instead of one write per request.
+    auto status = request_status::incomplete;
+    for (size_t answered = 0;
+         answered < MAX_PIPELINED_RESPONSES && !state.read_buffer.empty();
+         ++answered) {
+        auto next = process_request(state, zerocopy_threshold);
+        if (next == request_status::incomplete) {
+            break;
+        }
+        status = next;
+        if (next == request_status::respond_and_close) {
+            break;
+        }
+    }
+    return status;
+}
+
+void server::queue_response(connection_state& state, response& resp, size_t zerocopy_threshold) {
+    auto& out = state.responses.emplace_back();
+    out.head_offset = state.heads.size();
+    if (resp.chunked) {
+        state.heads.append(resp.serialize_chunked());
+    } else {
+        resp.append_head_to(state.heads);
+        out.body = std::move(resp.body);
+    }
+    out.head_size = state.heads.size() - out.head_offset;
+    out.zerocopy = out.body.size() >= zerocopy_threshold;
+}
+
+bool server::has_output(const connection_state& state) noexcept {
+    return state.current < state.responses.size();
+}
 
-            state.write_buffer.consume(write_result.value());
+bool server::zerocopy_pending(const connection_state& state) noexcept {
+    if (!has_output(state)) {
+        return false;
+    }
+    const auto& out = state.responses[state.current];
+    return out.zerocopy && state.current_sent >= out.head_size;
+}
+
+std::span<const uint8_t> server::unsent_body(const connection_state& state) noexcept {
+    const auto& out = state.responses[state.current];
+    return as_bytes(out.body).subspan(state.current_sent - out.head_size);
+}
+
+void server::gather_output(connection_state& state) {
+    state.output.clear();
+    const std::string_view heads(state.heads);
+    size_t skip = state.current_sent;
+    for (size_t i = state.current; i < state.responses.size(); ++i) {
+        const auto& out = state.responses[i];
+        if (skip < out.head_size) {
+            state.output.add_buffer(as_bytes(heads.substr(out.head_offset + skip,
+                                                          out.head_size - skip)));
+            skip = 0;
+        } else {
+            skip -= out.head_size;
+        }
+        // A zero-copy body needs its own send; the batch stops in front of it.
+        if (out.zerocopy) {
+            break;
         }
+        state.output.add_buffer(as_bytes(out.body).subspan(skip));
+        skip = 0;
+    }
+}
 
-        if (!state.write_buffer.empty()) {
+void server::advance_output(connection_state& state, size_t bytes) noexcept {
+    while (bytes > 0 && has_output(state)) {
+        const auto& out = state.responses[state.current];
+        size_t left = out.head_size + out.body.size() - state.current_sent;
+        if (bytes < left) {
+            state.current_sent += bytes;
             return;
         }
+        bytes -= left;
+        ++state.current;
+        state.current_sent = 0;
+    }
+}
 
-        state.arena.reset();
-        state.http_parser.reset(&state.arena);
-        state.write_buffer.clear();
-        state.watch->modify(event_type::readable);
-        return;
+void server::reset_output(connection_state& state) {
+    state.heads.clear();
+    state.responses.clear();
+    state.current = 0;
+    state.current_sent = 0;
+}
+
+bool server::handle_connection(connection_state& state, [[maybe_unused]] reactor& r) {
+    // Zerocopy completions arrive on the error queue, which epoll reports as EPOLLERR.
+    if (!state.pinned_bodies.empty()) {
+        release_sent_bodies(state);
     }
 
     while (true) {
-        if (state.read_buffer.empty()) {
-            auto buf = state.read_buffer.writable_span(4096);
-            auto read_result = state.socket.read(buf);
-
-            if (!read_result) {
-                if (read_result.error().value() == EAGAIN ||
-                    read_result.error().value() == EWOULDBLOCK) {
-                    break;
+        while (has_output(state)) {
+            result<size_t> written;
+            if (zerocopy_pending(state)) {
+                written = state.socket.write_zerocopy(unsent_body(state));
+            } else {
+                gather_output(state);
+                written = write_vectored(state.socket.native_handle(), state.output);
+                if (!written && (written.error().value() == EAGAIN ||
+                                 written.error().value() == EWOULDBLOCK ||
+                                 written.error().value() == EINTR)) {
+                    written = 0;
                 }
-                state.watch.reset();
-                return;
             }
 
-            if (read_result->empty()) {
+            if (!written) {
                 state.watch.reset();
-                return;
+                return false;
             }
+            if (*written == 0) {
+                state.watch->modify(event_type::writable);
+                state.waiting_writable = true;
+                return false;
+            }
+            advance_output(state, *written);
+        }
 
-            state.read_buffer.commit(read_result->size());
+        bool pinned = false;
+        for (auto& out : state.responses) {
+            if (out.zerocopy) {
+                state.pinned_bodies.emplace_back(state.socket.zerocopy_sends(),
+                                                 std::move(out.body));
+                pinned = true;
+            }
+        }
+        if (pinned) {
+            release_sent_bodies(state);
+        }
+        reset_output(state);
+
+        if (state.close_after_write) {
+            if (!state.pinned_bodies.empty()) {
+                // Keep the socket open until the kernel releases the bodies; only the error
+                // queue (always reported) needs to wake us meanwhile.
+                state.watch->modify(event_type::none);
+                state.waiting_writable = false;
+                return false;
+            }
+            state.watch.reset();
+            return false;
         }
 
-        auto readable = state.read_buffer.readable_span();
-        auto parse_result = state.http_parser.parse(readable);
+        if (state.waiting_writable) {
+            state.watch->modify(event_type::readable);
+            state.waiting_writable = false;
+        }
 
-        if (!parse_result) {
-            auto resp = response::error(problem_details::bad_request("Invalid HTTP request"));
-            state.write_buffer.append(resp.serialize());
-            state.watch.reset();
-            return;
+        auto status = state.read_buffer.empty() ? request_status::incomplete
+                                                : process_pipelined(state, zerocopy_threshold_);
+        if (status != request_status::incomplete && state.read_buffer.empty()) {
+            // A large body grew the buffer; that storage is not kept while the connection idles.
+            state.read_buffer.shrink_to_fit();
         }
+        if (status == request_status::incomplete) {
+            auto buf = state.read_buffer.writable_span(4096);
+            auto read_result = state.socket.read(buf);
 
-        if (!state.http_parser.is_complete()) {
+            if (!read_result) {
+                state.watch.reset();
+                return false;
+            }
+
+            // tcp_socket::read reports EAGAIN as an empty span and EOF as an error.
+            if (read_result->empty()) {
+                return state.read_buffer.empty() && state.pinned_bodies.empty();
+            }
+
+            state.read_buffer.commit(read_result->size());
             continue;
         }
 
-        size_t parsed_bytes = state.http_parser.bytes_parsed();
-        state.read_buffer.consume(parsed_bytes);
+        state.close_after_write = status == request_status::respond_and_close;
+    }
+}
 
-        const auto& req = state.http_parser.get_request();
-        request_context ctx{state.arena};
-        auto resp = dispatch_or_problem(router_, req, ctx);
+void server::release_sent_bodies(connection_state& state) {
+    auto completed = state.socket.reap_zerocopy();
+    if (!completed) {
+        return;
+    }
+    while (!state.pinned_bodies.empty() &&
+           static_cast<int32_t>(*completed - state.pinned_bodies.front().first) >= 0) {
+        state.pinned_bodies.pop_front();
+    }
+}
 
-        if (on_request_callback_) {
-            on_request_callback_(req, resp);
-        }
+#if defined(KATANA_USE_IO_URING)
+void server::start_receive(const connection_ptr& state, reactor& r) {
+    auto res = r.submit_multishot_recv(
+        state->socket.native_handle(),
+        [this, state, &r](int32_t n, std::span<const uint8_t> data) {
+            on_receive(state, r, n, data);
+        });
+    if (!res) {
+        close_connection(state, r);
+    }
+}
 
-        auto connection_header = req.headers.get("Connection");
-        bool close_connection =
-            connection_header && (*connection_header == "close" || *connection_header == "Close");
+void server::on_receive(const connection_ptr& state,
+                        reactor& r,
+                        int32_t res,
+                        std::span<const uint8_t> data) {
+    if (res == -ECANCELED && state->recv_paused) {
+        state->recv_stopped = true;
+        resume_receive(state, r);
+        return;
+    }
+    if (res <= 0) {
+        close_connection(state, r);
+        return;
+    }
+    if (state->closing) {
+        return;
+    }
 
-        if (!resp.headers.get("Connection")) {
-            resp.set_header("Connection", close_connection ? "close" : "keep-alive");
+    // The provided buffer goes back to the ring when this returns, so unparsed bytes are
+    // copied out; the read buffer only holds storage while a request is partially received.
+    state->read_buffer.append(data);
+    if (!state->send_in_flight) {
+        serve_buffered(state, r);
+    } else if (state->read_buffer.size() > MAX_BUFFER_SIZE) {
+        // The client pipelines faster than it reads: stop receiving until the responses to
+        // what is buffered have gone out, as epoll does by not reading while it writes.
+        // Completions already queued still arrive, and each asks again in case the first
+        // cancel raced a re-arm.
+        state->recv_paused = true;
+        if (!r.cancel_recv(state->socket.native_handle())) {
+            close_connection(state, r);
         }
+    }
+}
 
-        state.write_buffer.append(resp.serialize());
+void server::serve_buffered(const connection_ptr& state, reactor& r) {
+    auto status =
+        process_pipelined(*state, r.supports_send_zc() ? zerocopy_threshold_ : SIZE_MAX);
+    if (status == request_status::incomplete) {
+        return;
+    }
 
-        while (!state.write_buffer.empty()) {
-            auto data = state.write_buffer.readable_span();
-            auto write_result = state.socket.write(data);
+    if (state->read_buffer.empty()) {
+        state->read_buffer.shrink_to_fit();
+    }
+    state->close_after_write = status == request_status::respond_and_close;
+    start_send(state, r);
+}
 
-            if (!write_result) {
-                if (write_result.error().value() == EAGAIN ||
-                    write_result.error().value() == EWOULDBLOCK) {
-                    state.watch->modify(event_type::writable);
-                    return;
-                }
-                state.watch.reset();
-                return;
-            }
+void server::start_send(const connection_ptr& state, reactor& r) {
+    state->send_in_flight = true;
+    auto completion = [this, state, &r](int32_t n) { on_send(state, r, n); };
+    result<void> res;
+    if (zerocopy_pending(*state)) {
+        // The completion only fires once the kernel has released the pages, so the body stays
+        // owned by the connection until then.
+        res = r.submit_send_zc(
+            state->socket.native_handle(), unsent_body(*state), std::move(completion));
+    } else {
+        gather_output(*state);
+        res = r.submit_writev(state->socket.native_handle(),
+                              std::span<const iovec>(state->output.iov(), state->output.count()),
+                              std::move(completion));
+    }
+    if (!res) {
+        state->send_in_flight = false;
+        close_connection(state, r);
+    }
+}
 
-            if (write_result.value() == 0) {
-                break;
-            }
+void server::on_send(const connection_ptr& state, reactor& r, int32_t res) {
+    state->send_in_flight = false;
+    if (res == -EINTR || res == -EAGAIN) {
+        start_send(state, r);
+        return;
+    }
+    if (res <= 0) {
+        close_connection(state, r);
+        return;
+    }
 
-            state.write_buffer.consume(write_result.value());
-        }
+    advance_output(*state, static_cast<size_t>(res));
+    if (has_output(*state)) {
+        start_send(state, r);
+        return;
+    }
+    reset_output(*state);
 
-        if (!state.write_buffer.empty()) {
-            state.watch->modify(event_type::writable);
-            return;
-        }
+    if (state->close_after_write) {
+        close_connection(state, r);
+        return;
+    }
 
-        if (close_connection) {
-            state.watch.reset();
-            return;
-        }
+    if (!state->read_buffer.empty()) {
+        serve_buffered(state, r);
+    }
+    resume_receive(state, r);
+}
 
-        state.arena.reset();
-        state.http_parser.reset(&state.arena);
+void server::resume_receive(const connection_ptr& state, reactor& r) {
+    if (!state->recv_stopped || state->closing || state->read_buffer.size() > MAX_BUFFER_SIZE) {
+        return;
     }
+    state->recv_paused = false;
+    state->recv_stopped = false;
+    start_receive(state, r);
 }
 
-void server::accept_connection(reactor& r,
-                               tcp_listener& listener,
-                               std::vector<std::unique_ptr<connection_state>>& connections) {
-    auto accept_result = listener.accept();
-    if (!accept_result) {
+void server::close_connection(const connection_ptr& state, reactor& r) {
+    if (state->closing) {
         return;
     }
+    state->closing = true;
 
-    auto state = std::make_unique<connection_state>(std::move(*accept_result));
+    // Shutting the socket down ends the multishot recv (EOF) and any pending send. The fd is
+    // closed once the last in-flight op drops its reference to the connection, so it cannot
+    // be reused while SQEs naming it are still queued. The registered table slot holds its
+    // own file reference and is dropped here, before that close.
     int32_t fd = state->socket.native_handle();
+    ::shutdown(fd, SHUT_RDWR);
+    (void)r.unregister_file(fd);
+}
+#endif
 
-    auto* state_ptr = state.get();
-    state->watch =
-        std::make_unique<fd_watch>(r, fd, event_type::readable, [this, state_ptr, &r](event_type) {
-            handle_connection(*state_ptr, r);
+#if !defined(KATANA_USE_IO_URING)
+void server::watch_connection(std::shared_ptr<connection_state> state, reactor& r) {
+    auto state_ptr = state.get();
+    int32_t fd = state->socket.native_handle();
+    state->watch = std::make_unique<fd_watch>(
+        r, fd, event_type::readable, [this, state, state_ptr, &r](event_type) {
+            // Once the watch is gone this callback (and its captures) may be destroyed.
+            if (handle_connection(*state_ptr, r)) {
+                migrate_if_hot(state, r);
+            }
         });
+    r.set_fd_prefetch_hint(fd, state_ptr);
+}
 
-    connections.push_back(std::move(state));
+void server::migrate_if_hot(std::shared_ptr<connection_state> state, reactor& r) {
+    auto target = pool_ ? pool_->migration_target() : std::nullopt;
+    if (!target) {
+        return;
+    }
+
+    // Level-triggered registration on the new reactor picks up anything that arrives while the
+    // connection is in flight. The old callback holds a reference, so `state` keeps it alive.
+    state->watch.reset();
+    auto& next = pool_->get_reactor(*target);
+    auto adopt = [this, moving = state, &next]() { watch_connection(moving, next); };
+    if (!pool_->post(*target, std::move(adopt))) {
+        watch_connection(std::move(state), r);
+    }
+}
+#endif
+
+void server::accept_connection(reactor& r, int32_t fd) {
+    auto state = std::make_shared<connection_state>(tcp_socket(fd));
+#if defined(KATANA_USE_IO_URING)
+    // Best effort: without a registered slot the ops fall back to a normal fd lookup.
+    (void)r.register_file(fd);
+    start_receive(state, r);
+#else
+    watch_connection(std::move(state), r);
+#endif
 }
 
 int server::run() {
     reactor_pool_config config;
     config.reactor_count = static_cast<uint32_t>(worker_count_);
     config.enable_adaptive_balancing = true;
+    config.enable_connection_migration = connection_migration_;
+    config.enable_cpu_steering = cpu_steering_;
+    config.epoll_spin_budget_us = static_cast<uint32_t>(spin_budget_.count());
+    config.epoll_writable_first = writable_first_;
     reactor_pool pool(config);
+    pool_ = &pool;
 
-    std::vector<std::shared_ptr<fd_watch>> accept_watches;
-
-    auto accept_handler = [this](reactor& r, int listener_fd) {
-        while (true) {
-            int fd = ::accept4(listener_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
-            if (fd < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    break;
-                }
-                return;
-            }
-
-            auto state = std::make_shared<connection_state>(tcp_socket(fd));
-            auto state_ptr = state.get();
-
-            state->watch = std::make_unique<fd_watch>(
-                r, fd, event_type::readable, [this, state, state_ptr, &r](event_type) {
-                    handle_connection(*state_ptr, r);
-                });
-        }
-    };
+    auto on_connection = [this](reactor& r, int32_t fd) { accept_connection(r, fd); };
 
+    // Declared at function scope: the fallback listener must outlive the reactors using it.
+    tcp_listener listener;
     if (reuseport_) {
-        auto res = pool.start_listening(port_, accept_handler);
+        auto res = pool.start_accepting(port_, on_connection);
         if (!res) {
             std::cerr << "Failed to start listeners on port " << port_ << ": "
                       << res.error().message() << "\n";
@@ -191,20 +449,26 @@ int server::run() {
         }
     } else {
         // Fallback: single listener on reactor 0
-        tcp_listener listener(port_);
+        listener = tcp_listener(port_);
         if (!listener) {
             std::cerr << "Failed to create listener on port " << port_ << "\n";
             return 1;
         }
         listener.set_reuseport(false).set_backlog(backlog_);
 
-        auto& r = pool.get_reactor(0);
-        auto listen_fd = listener.native_handle();
-        auto listen_watch = std::make_shared<fd_watch>(
-            r, listen_fd, event_type::readable, [this, &r, &listener, accept_handler](event_type) {
-                accept_handler(r, listener.native_handle());
-            });
-        accept_watches.push_back(std::move(listen_watch));
+        auto res =
+            reactor_pool::accept_on(pool.get_reactor(0), listener.native_handle(), on_connection);
+        if (!res) {
+            std::cerr << "Failed to start listener on port " << port_ << ": "
+                      << res.error().message() << "\n";
+            return 1;
+        }
+    }
+
+    if (hot_route_cache_) {
+        for (auto& r : pool) {
+            r.schedule([&r]() { route_cache::local().publish_to(&r.metrics()); });
+        }
     }
 
     // Setup signal handlers for graceful shutdown
@@ -227,6 +491,7 @@ int server::run() {
 
     pool.start();
     pool.wait();
+    pool_ = nullptr;
     return 0;
 }
 
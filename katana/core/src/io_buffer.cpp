@@ -26,26 +26,21 @@ std::unique_ptr<uint8_t[], io_buffer::aligned_delete> allocate_raw(size_t n) {
 }
 } // namespace
 
-alignas(64) thread_local uint8_t io_buffer::static_scratch_[io_buffer::STATIC_SCRATCH_CAPACITY];
-
-io_buffer::io_buffer() {
-    // Default to the per-thread scratch arena to avoid heap work on the hot path.
-    data_ = static_scratch_;
-    capacity_ = STATIC_SCRATCH_CAPACITY;
-}
+// Every buffer owns its storage: connections keep unread input and pending output across
+// reactor events (and across in-flight io_uring ops), so storage must never be shared.
+// The default constructor allocates nothing until the first write.
+io_buffer::io_buffer() = default;
 
 io_buffer::io_buffer(size_t capacity) : capacity_(capacity) {
-    if (capacity_ == 0 || capacity_ <= STATIC_SCRATCH_CAPACITY) {
-        data_ = static_scratch_;
-        capacity_ = STATIC_SCRATCH_CAPACITY;
-    } else {
-        owner_ = allocate_raw(capacity_);
-        data_ = owner_.get();
-    }
+    owner_ = allocate_raw(capacity_);
+    data_ = owner_.get();
 }
 
 void io_buffer::append(std::span<const uint8_t> data) {
     const size_t data_size = data.size();
+    if (data_size == 0) {
+        return;
+    }
     const size_t new_write_pos = write_pos_ + data_size;
 
     // Fast path: enough space already available.
@@ -97,6 +92,17 @@ void io_buffer::clear() noexcept {
     write_pos_ = 0;
 }
 
+void io_buffer::shrink_to_fit() noexcept {
+    if (!empty()) {
+        return;
+    }
+    owner_.reset();
+    data_ = nullptr;
+    capacity_ = 0;
+    read_pos_ = 0;
+    write_pos_ = 0;
+}
+
 void io_buffer::reserve(size_t new_capacity) {
     if (new_capacity > capacity_) {
         // Allocate new storage and preserve unread data at the front.
@@ -3,10 +3,13 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <poll.h>
 #include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <system_error>
 #include <unistd.h>
 
@@ -48,7 +51,9 @@ constexpr event_type from_poll_events(uint32_t events) noexcept {
 
 } // namespace
 
-io_uring_reactor::io_uring_reactor(size_t ring_size, size_t max_pending_tasks)
+io_uring_reactor::io_uring_reactor(size_t ring_size,
+                                   size_t max_pending_tasks,
+                                   const io_uring_setup_options& options)
     : wakeup_fd_(-1), running_(false), graceful_shutdown_(false), pending_tasks_(max_pending_tasks),
       pending_timers_(max_pending_tasks), exception_handler_([](const exception_context& ctx) {
           std::cerr << "[reactor] Exception in " << ctx.location;
@@ -70,12 +75,30 @@ io_uring_reactor::io_uring_reactor(size_t ring_size, size_t max_pending_tasks)
     io_uring_params params{};
     params.flags = IORING_SETUP_CQSIZE;
     params.cq_entries = static_cast<__u32>(ring_size * 2);
+    if (options.sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = options.sqpoll_idle_ms;
+    }
+    if (options.single_issuer || options.defer_taskrun) {
+        // The constructing thread is usually not the one that will run the loop, so the
+        // ring is enabled (and its issuer fixed) from run().
+        params.flags |= IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_R_DISABLED;
+        ring_disabled_ = true;
+    }
+    if (options.defer_taskrun) {
+        params.flags |= IORING_SETUP_DEFER_TASKRUN;
+    }
 
     int ret = io_uring_queue_init_params(static_cast<unsigned int>(ring_size), &ring_, &params);
     if (ret < 0) {
         throw std::system_error(-ret, std::system_category(), "io_uring_queue_init_params failed");
     }
 
+    if (io_uring_probe* probe = io_uring_get_probe_ring(&ring_)) {
+        send_zc_supported_ = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC) != 0;
+        io_uring_free_probe(probe);
+    }
+
     // Use RAII wrapper for exception safety - will auto-cleanup if construction fails
     scoped_fd wakeup_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
     if (!wakeup_fd.is_valid()) {
@@ -83,7 +106,6 @@ io_uring_reactor::io_uring_reactor(size_t ring_size, size_t max_pending_tasks)
         throw std::system_error(errno, std::system_category(), "eventfd failed");
     }
 
-    fd_states_.reserve(65536);
 
     // Everything succeeded, release ownership from RAII wrapper
     wakeup_fd_ = wakeup_fd.release();
@@ -93,6 +115,9 @@ io_uring_reactor::~io_uring_reactor() noexcept {
     if (wakeup_fd_ >= 0) {
         close(wakeup_fd_);
     }
+    if (buf_ring_) {
+        io_uring_free_buf_ring(&ring_, buf_ring_, PROVIDED_BUFFER_COUNT, PROVIDED_BUFFER_GROUP);
+    }
     io_uring_queue_exit(&ring_);
 }
 
@@ -101,6 +126,15 @@ result<void> io_uring_reactor::run() {
         return std::unexpected(make_error_code(error_code::reactor_stopped));
     }
 
+    if (ring_disabled_) {
+        int ret = io_uring_enable_rings(&ring_);
+        if (ret < 0) {
+            running_ = false;
+            return std::unexpected(std::error_code(-ret, std::system_category()));
+        }
+        ring_disabled_ = false;
+    }
+
     auto wakeup_res = register_fd(
         wakeup_fd_, event_type::readable | event_type::edge_triggered, [this](event_type) {
             uint64_t val;
@@ -114,40 +148,35 @@ result<void> io_uring_reactor::run() {
     }
 
     while (running_.load(std::memory_order_relaxed)) {
-        process_wheel_timer();
         process_timers();
         process_tasks();
 
         if (graceful_shutdown_.load(std::memory_order_relaxed)) {
             auto now = std::chrono::steady_clock::now();
             bool has_active_fds = false;
-            for (const auto& state : fd_states_) {
-                if (state.callback) {
-                    has_active_fds = true;
-                    break;
-                }
-            }
+            fds_.for_each([&](int32_t, fd_state& state) { has_active_fds |= !!state.callback; });
             if (!has_active_fds) {
                 running_ = false;
                 break;
             }
             if (now >= graceful_shutdown_deadline_) {
-                for (size_t fd = 0; fd < fd_states_.size(); ++fd) {
-                    if (!fd_states_[fd].callback)
-                        continue;
+                fds_.for_each([&](int32_t fd, fd_state& state) {
+                    if (!state.callback)
+                        return;
                     try {
-                        fd_states_[fd].callback(event_type::error);
+                        state.callback(event_type::error);
                     } catch (...) {
-                        handle_exception("forced_shutdown_callback",
-                                         std::current_exception(),
-                                         static_cast<int32_t>(fd));
+                        handle_exception(
+                            "forced_shutdown_callback", std::current_exception(), fd);
                     }
-                    if (fd_states_[fd].callback) {
-                        submit_poll_remove(static_cast<int32_t>(fd));
-                        close(static_cast<int32_t>(fd));
-                        fd_states_[fd] = fd_state{};
+                    if (fds_.find(fd) == &state && state.callback) {
+                        submit_poll_remove(fds_.handle_of(fd));
+                        // A registered table slot would keep the socket open past close().
+                        (void)unregister_file(fd);
+                        close(fd);
+                        fds_.erase(fd);
                     }
-                }
+                });
                 running_ = false;
                 break;
             }
@@ -189,12 +218,12 @@ result<void> io_uring_reactor::register_fd(int32_t fd, event_type events, event_
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto ensure = ensure_fd_capacity(fd);
-    if (!ensure) {
-        return ensure;
+    auto handle = insert_fd(fd);
+    if (!handle) {
+        return std::unexpected(handle.error());
     }
 
-    auto& state = fd_states_[static_cast<size_t>(fd)];
+    auto& state = *fds_.resolve(*handle);
     state.callback = std::move(callback);
     state.events = events;
     state.timeouts = {};
@@ -204,7 +233,11 @@ result<void> io_uring_reactor::register_fd(int32_t fd, event_type events, event_
     state.registered = true;
 
     active_fds_.fetch_add(1, std::memory_order_relaxed);
-    return submit_poll_add(fd, events);
+    auto res = submit_poll_add(fd, *handle, events);
+    if (res) {
+        state.poll_armed = true;
+    }
+    return res;
 }
 
 result<void> io_uring_reactor::register_fd_with_timeout(int32_t fd,
@@ -215,12 +248,12 @@ result<void> io_uring_reactor::register_fd_with_timeout(int32_t fd,
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto ensure = ensure_fd_capacity(fd);
-    if (!ensure) {
-        return ensure;
+    auto handle = insert_fd(fd);
+    if (!handle) {
+        return std::unexpected(handle.error());
     }
 
-    fd_state state{};
+    auto& state = *fds_.resolve(*handle);
     state.callback = std::move(callback);
     state.events = events;
     state.timeouts = config;
@@ -228,69 +261,77 @@ result<void> io_uring_reactor::register_fd_with_timeout(int32_t fd,
     state.activity_timer = Timeout{};
     state.has_timeout = true;
     state.registered = true;
-    setup_fd_timeout(fd, state);
+    setup_fd_timeout(*handle, state);
 
-    auto res = submit_poll_add(fd, events);
+    auto res = submit_poll_add(fd, *handle, events);
     if (!res) {
         cancel_fd_timeout(state);
+        fds_.erase(fd);
         return res;
     }
 
-    fd_states_[static_cast<size_t>(fd)] = std::move(state);
+    state.poll_armed = true;
     active_fds_.fetch_add(1, std::memory_order_relaxed);
     return {};
 }
 
 result<void> io_uring_reactor::modify_fd(int32_t fd, event_type events) {
-    if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size() ||
-        !fd_states_[static_cast<size_t>(fd)].callback) {
+    auto* found = fds_.find(fd);
+    if (!found || !found->callback) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    auto& state = fd_states_[static_cast<size_t>(fd)];
+    auto& state = *found;
+    const uint64_t handle = fds_.handle_of(fd);
 
-    auto res = submit_poll_remove(fd);
-    if (!res) {
-        return res;
-    }
-
-    res = submit_poll_add(fd, events);
+    // An armed poll is retargeted in place; an unarmed one is either mid-dispatch or a fired
+    // oneshot, and both need a fresh poll with the new mask.
+    auto res = state.poll_armed ? submit_poll_update(handle, events)
+                                : submit_poll_add(fd, handle, events);
     if (!res) {
         return res;
     }
 
+    state.poll_armed = true;
     state.events = events;
     if (state.has_timeout) {
         cancel_fd_timeout(state);
-        setup_fd_timeout(fd, state);
+        setup_fd_timeout(handle, state);
     }
     return {};
 }
 
 result<void> io_uring_reactor::unregister_fd(int32_t fd) {
-    if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size() ||
-        !fd_states_[static_cast<size_t>(fd)].callback) {
+    auto* state = fds_.find(fd);
+    if (!state || !state->callback) {
         return std::unexpected(make_error_code(error_code::invalid_fd));
     }
 
-    cancel_fd_timeout(fd_states_[static_cast<size_t>(fd)]);
+    cancel_fd_timeout(*state);
 
-    auto res = submit_poll_remove(fd);
-    if (!res) {
-        return res;
+    if (state->poll_armed) {
+        auto res = submit_poll_remove(fds_.handle_of(fd));
+        if (!res) {
+            return res;
+        }
     }
 
-    fd_states_[static_cast<size_t>(fd)] = fd_state{};
+    fds_.erase(fd);
     active_fds_.fetch_sub(1, std::memory_order_relaxed);
     return {};
 }
 
+void io_uring_reactor::set_fd_prefetch_hint(int32_t fd, const void* object) noexcept {
+    if (auto* state = fds_.find(fd)) {
+        state->prefetch_hint = object;
+    }
+}
+
 void io_uring_reactor::refresh_fd_timeout(int32_t fd) {
-    if (fd >= 0 && static_cast<size_t>(fd) < fd_states_.size() &&
-        fd_states_[static_cast<size_t>(fd)].has_timeout) {
-        auto& state = fd_states_[static_cast<size_t>(fd)];
-        cancel_fd_timeout(state);
-        setup_fd_timeout(fd, state);
+    auto* state = fds_.find(fd);
+    if (state && state->has_timeout) {
+        cancel_fd_timeout(*state);
+        setup_fd_timeout(fds_.handle_of(fd), *state);
     }
 }
 
@@ -346,16 +387,292 @@ bool io_uring_reactor::schedule_after(std::chrono::milliseconds delay, task_fn t
     return true;
 }
 
-result<void> io_uring_reactor::submit_poll_add(int32_t fd, event_type events) {
-    io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+result<void>
+io_uring_reactor::submit_recv(int32_t fd, std::span<uint8_t> buffer, completion_callback callback) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    io_uring_prep_recv(sqe, fd, buffer.data(), buffer.size(), 0);
+    use_fixed_file(sqe, fd);
+    io_uring_sqe_set_data64(sqe, acquire_op(fd, op_type::recv, std::move(callback)));
+    return {};
+}
+
+result<void> io_uring_reactor::submit_send(int32_t fd,
+                                           std::span<const uint8_t> data,
+                                           completion_callback callback) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    io_uring_prep_send(sqe, fd, data.data(), data.size(), MSG_NOSIGNAL);
+    use_fixed_file(sqe, fd);
+    io_uring_sqe_set_data64(sqe, acquire_op(fd, op_type::send, std::move(callback)));
+    return {};
+}
+
+result<void> io_uring_reactor::submit_writev(int32_t fd,
+                                             std::span<const iovec> iov,
+                                             completion_callback callback) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    // sendmsg rather than writev: only the socket calls take MSG_NOSIGNAL, so a reset peer
+    // reports -EPIPE instead of raising SIGPIPE.
+    const uint64_t user_data = acquire_op(fd, op_type::writev, std::move(callback));
+    msghdr& msg = pending_ops_[user_data >> USER_DATA_TAG_BITS].msg;
+    msg = {};
+    msg.msg_iov = const_cast<iovec*>(iov.data());
+    msg.msg_iovlen = std::min<size_t>(iov.size(), IOV_MAX);
+    io_uring_prep_sendmsg(sqe, fd, &msg, MSG_NOSIGNAL);
+    use_fixed_file(sqe, fd);
+    io_uring_sqe_set_data64(sqe, user_data);
+    return {};
+}
+
+result<void> io_uring_reactor::submit_multishot_accept(int32_t listener_fd,
+                                                      completion_callback callback) {
+    if (listener_fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    uint64_t user_data = acquire_op(listener_fd, op_type::accept_multishot, std::move(callback));
+    auto res = arm_multishot(user_data >> USER_DATA_TAG_BITS);
+    if (!res) {
+        release_op(user_data >> USER_DATA_TAG_BITS);
+    }
+    return res;
+}
+
+result<void> io_uring_reactor::submit_multishot_recv(int32_t fd, buffer_callback callback) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    auto ring = ensure_buffer_ring();
+    if (!ring) {
+        return ring;
+    }
+
+    uint64_t user_data = acquire_op(fd, op_type::recv_multishot, {}, std::move(callback));
+    auto res = arm_multishot(user_data >> USER_DATA_TAG_BITS);
+    if (!res) {
+        release_op(user_data >> USER_DATA_TAG_BITS);
+    }
+    return res;
+}
+
+result<void> io_uring_reactor::cancel_ops(int32_t fd) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    unsigned int flags = IORING_ASYNC_CANCEL_ALL;
+    if (is_fixed_file(fd)) {
+        flags |= IORING_ASYNC_CANCEL_FD_FIXED;
+    }
+    io_uring_prep_cancel_fd(sqe, fd, flags);
+    io_uring_sqe_set_data64(sqe, make_user_data(op_type::cancel, 0));
+    // Cancel-by-fd resolves the fd when the kernel processes it, so it has to be submitted
+    // before the caller closes the descriptor.
+    auto submitted = flush_submissions();
+
+    // A parked accept has nothing in the ring for the kernel to cancel.
+    for (size_t slot = 0; slot < pending_ops_.size(); ++slot) {
+        if (pending_ops_[slot].parked && pending_ops_[slot].fd == fd) {
+            invoke_multishot(slot, -ECANCELED, {}, true);
+        }
+    }
+    return submitted;
+}
+
+result<void> io_uring_reactor::cancel_recv(int32_t fd) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    for (size_t slot = 0; slot < pending_ops_.size(); ++slot) {
+        const auto& op = pending_ops_[slot];
+        if (op.fd != fd || op.type != op_type::recv_multishot) {
+            continue;
+        }
+        io_uring_sqe* sqe = get_sqe();
+        if (!sqe) {
+            return std::unexpected(make_error_code(error_code::reactor_stopped));
+        }
+        io_uring_prep_cancel64(sqe, make_user_data(op_type::recv_multishot, slot), 0);
+        io_uring_sqe_set_data64(sqe, make_user_data(op_type::cancel, 0));
+        return {};
+    }
+    return std::unexpected(make_error_code(error_code::invalid_fd));
+}
+
+result<void> io_uring_reactor::submit_send_zc(int32_t fd,
+                                              std::span<const uint8_t> data,
+                                              completion_callback callback) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+    if (!send_zc_supported_) {
+        return std::unexpected(std::make_error_code(std::errc::operation_not_supported));
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    io_uring_prep_send_zc(sqe, fd, data.data(), data.size(), MSG_NOSIGNAL, 0);
+    use_fixed_file(sqe, fd);
+    io_uring_sqe_set_data64(sqe, acquire_op(fd, op_type::send_zc, std::move(callback)));
+    return {};
+}
+
+result<void> io_uring_reactor::register_file(int32_t fd) {
+    if (fd < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    auto table = ensure_file_table();
+    if (!table) {
+        return table;
+    }
+    if (static_cast<size_t>(fd) >= fixed_files_.size()) {
+        return std::unexpected(std::make_error_code(std::errc::too_many_files_open));
+    }
+
+    int ret = io_uring_register_files_update(&ring_, static_cast<unsigned>(fd), &fd, 1);
+    if (ret < 0) {
+        return std::unexpected(std::error_code(-ret, std::system_category()));
+    }
+
+    fixed_files_[static_cast<size_t>(fd)] = 1;
+    return {};
+}
+
+result<void> io_uring_reactor::unregister_file(int32_t fd) {
+    if (!is_fixed_file(fd)) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    // SQEs already queued against the slot fail with EBADF instead of reaching a new file.
+    const int32_t empty_slot = -1;
+    int ret = io_uring_register_files_update(&ring_, static_cast<unsigned>(fd), &empty_slot, 1);
+    fixed_files_[static_cast<size_t>(fd)] = 0;
+    if (ret < 0) {
+        return std::unexpected(std::error_code(-ret, std::system_category()));
+    }
+
+    return {};
+}
+
+result<void> io_uring_reactor::ensure_file_table() {
+    if (file_table_state_ == registration_state::active) {
+        return {};
+    }
+    if (file_table_state_ == registration_state::unavailable) {
+        return std::unexpected(std::make_error_code(std::errc::not_supported));
+    }
+
+    // The kernel caps the table at RLIMIT_NOFILE.
+    uint32_t size = FIXED_FILE_TABLE_SIZE;
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < size) {
+        size = static_cast<uint32_t>(limit.rlim_cur);
+    }
+
+    int ret = io_uring_register_files_sparse(&ring_, size);
+    if (ret < 0) {
+        file_table_state_ = registration_state::unavailable;
+        return std::unexpected(std::error_code(-ret, std::system_category()));
+    }
+
+    fixed_files_.assign(size, 0);
+    file_table_state_ = registration_state::active;
+    return {};
+}
+
+bool io_uring_reactor::is_fixed_file(int32_t fd) const noexcept {
+    return fd >= 0 && static_cast<size_t>(fd) < fixed_files_.size() &&
+           fixed_files_[static_cast<size_t>(fd)] != 0;
+}
+
+void io_uring_reactor::use_fixed_file(io_uring_sqe* sqe, int32_t fd) const noexcept {
+    // Slot == fd, so sqe->fd already names the registered slot.
+    if (is_fixed_file(fd)) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+}
+
+result<void> io_uring_reactor::submit_poll_add(int32_t fd, uint64_t handle, event_type events) {
+    io_uring_sqe* sqe = get_sqe();
     if (!sqe) {
         return std::unexpected(make_error_code(error_code::reactor_stopped));
     }
 
     uint32_t poll_mask = to_poll_events(events);
     io_uring_prep_poll_add(sqe, fd, poll_mask);
-    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(fd)));
+    io_uring_sqe_set_data64(sqe, make_user_data(op_type::poll_add, handle));
+    return {};
+}
+
+result<void> io_uring_reactor::submit_poll_update(uint64_t handle, event_type events) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
 
+    const uint64_t poll_data = make_user_data(op_type::poll_add, handle);
+    io_uring_prep_poll_update(
+        sqe, poll_data, poll_data, to_poll_events(events), IORING_POLL_UPDATE_EVENTS);
+    io_uring_sqe_set_data64(sqe, make_user_data(op_type::poll_remove, handle));
+    return {};
+}
+
+result<void> io_uring_reactor::submit_poll_remove(uint64_t handle) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return std::unexpected(make_error_code(error_code::reactor_stopped));
+    }
+
+    io_uring_prep_poll_remove(sqe, make_user_data(op_type::poll_add, handle));
+    io_uring_sqe_set_data64(sqe, make_user_data(op_type::poll_remove, handle));
+    return {};
+}
+
+io_uring_sqe* io_uring_reactor::get_sqe() {
+    io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) {
+        // SQ is full: push what is queued so far to make room.
+        (void)flush_submissions();
+        sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+}
+
+result<void> io_uring_reactor::flush_submissions() {
     int ret = io_uring_submit(&ring_);
     if (ret < 0) {
         return std::unexpected(std::error_code(-ret, std::system_category()));
@@ -364,23 +681,265 @@ result<void> io_uring_reactor::submit_poll_add(int32_t fd, event_type events) {
     return {};
 }
 
-result<void> io_uring_reactor::submit_poll_remove(int32_t fd) {
-    io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+uint64_t io_uring_reactor::acquire_op(int32_t fd,
+                                      op_type type,
+                                      completion_callback callback,
+                                      buffer_callback on_data) {
+    uint32_t slot;
+    if (!free_op_slots_.empty()) {
+        slot = free_op_slots_.back();
+        free_op_slots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(pending_ops_.size());
+        pending_ops_.emplace_back();
+    }
+
+    auto& op = pending_ops_[slot];
+    op.callback = std::move(callback);
+    op.on_data = std::move(on_data);
+    op.fd = fd;
+    op.type = type;
+    op.deferred_result = 0;
+    return make_user_data(type, slot);
+}
+
+void io_uring_reactor::release_op(uint64_t slot) {
+    auto& op = pending_ops_[slot];
+    op.callback = {};
+    op.on_data = {};
+    op.fd = -1;
+    op.parked = false;
+    free_op_slots_.push_back(static_cast<uint32_t>(slot));
+}
+
+void io_uring_reactor::complete_op(uint64_t slot, int32_t res) {
+    if (slot >= pending_ops_.size() || pending_ops_[slot].fd < 0) {
+        return;
+    }
+
+    // Release the slot before invoking: the callback usually submits its follow-up op.
+    auto& op = pending_ops_[slot];
+    completion_callback callback = std::move(op.callback);
+    int32_t fd = op.fd;
+    release_op(slot);
+
+    try {
+        callback(res);
+        metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("completion_callback", std::current_exception(), fd);
+    }
+}
+
+void io_uring_reactor::complete_send_zc(uint64_t slot, int32_t res, uint32_t cqe_flags) {
+    if (slot >= pending_ops_.size() || pending_ops_[slot].fd < 0) {
+        return;
+    }
+
+    // A successful send yields two CQEs: the result (flagged MORE) and, once the pages are
+    // released, a NOTIF. Failed sends produce only the first.
+    if ((cqe_flags & IORING_CQE_F_NOTIF) != 0) {
+        complete_op(slot, pending_ops_[slot].deferred_result);
+    } else if ((cqe_flags & IORING_CQE_F_MORE) != 0) {
+        pending_ops_[slot].deferred_result = res;
+    } else {
+        complete_op(slot, res);
+    }
+}
+
+result<void> io_uring_reactor::arm_multishot(uint64_t slot) {
+    io_uring_sqe* sqe = get_sqe();
     if (!sqe) {
         return std::unexpected(make_error_code(error_code::reactor_stopped));
     }
 
-    io_uring_prep_poll_remove(sqe, static_cast<__u64>(static_cast<uintptr_t>(fd)));
+    const auto& op = pending_ops_[slot];
+    if (op.type == op_type::accept_multishot) {
+        io_uring_prep_multishot_accept(sqe, op.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } else {
+        io_uring_prep_recv_multishot(sqe, op.fd, nullptr, 0, 0);
+        use_fixed_file(sqe, op.fd);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = PROVIDED_BUFFER_GROUP;
+    }
+    io_uring_sqe_set_data64(sqe, make_user_data(op.type, slot));
+    return {};
+}
 
-    int ret = io_uring_submit(&ring_);
-    if (ret < 0) {
+void io_uring_reactor::complete_multishot(uint64_t slot, int32_t res, uint32_t cqe_flags) {
+    if (slot >= pending_ops_.size() || pending_ops_[slot].fd < 0) {
+        return;
+    }
+
+    const bool has_buffer = (cqe_flags & IORING_CQE_F_BUFFER) != 0;
+    const auto buffer_id = static_cast<uint16_t>(cqe_flags >> IORING_CQE_BUFFER_SHIFT);
+
+    // The kernel also ends a multishot op when the buffer ring runs dry (-ENOBUFS) or, rarely,
+    // after a successful completion; neither ends the stream. Accept only ends on cancel: a
+    // failed accept (out of fds, say) must not leave the listener deaf, so it is re-armed too,
+    // after a pause when the process is out of descriptors or memory. Re-arm before running
+    // callbacks so a cancel_ops issued from one of them also covers the new SQE.
+    bool last = (cqe_flags & IORING_CQE_F_MORE) == 0;
+    bool rearm_failed = false;
+    if (last && pending_ops_[slot].type == op_type::accept_multishot && res != -ECANCELED) {
+        const bool exhausted =
+            res == -EMFILE || res == -ENFILE || res == -ENOBUFS || res == -ENOMEM;
+        rearm_failed = exhausted ? !park_accept(slot) : !arm_multishot(slot);
+        last = false;
+    } else if (last && (res > 0 || res == -ENOBUFS)) {
+        rearm_failed = !arm_multishot(slot);
+        last = false;
+    }
+
+    if (res != -ENOBUFS || pending_ops_[slot].type == op_type::accept_multishot) {
+        std::span<const uint8_t> data;
+        if (has_buffer && res > 0) {
+            data = std::span<const uint8_t>(
+                buf_ring_storage_.get() + size_t{buffer_id} * PROVIDED_BUFFER_SIZE,
+                static_cast<size_t>(res));
+        }
+        invoke_multishot(slot, res, data, last);
+    }
+
+    if (has_buffer) {
+        recycle_buffer(buffer_id);
+    }
+
+    if (rearm_failed) {
+        invoke_multishot(slot, -EIO, {}, true);
+    }
+}
+
+bool io_uring_reactor::park_accept(uint64_t slot) {
+    pending_ops_[slot].parked = true;
+    return schedule_after(ACCEPT_RETRY_DELAY, [this, slot]() {
+        auto& op = pending_ops_[slot];
+        if (!op.parked) {
+            return; // cancelled meanwhile
+        }
+        op.parked = false;
+        if (!arm_multishot(slot)) {
+            invoke_multishot(slot, -EIO, {}, true);
+        }
+    });
+}
+
+void io_uring_reactor::invoke_multishot(uint64_t slot,
+                                        int32_t res,
+                                        std::span<const uint8_t> data,
+                                        bool last) {
+    auto& op = pending_ops_[slot];
+    const int32_t fd = op.fd;
+    try {
+        if (op.type == op_type::recv_multishot) {
+            if (last) {
+                buffer_callback callback = std::move(op.on_data);
+                release_op(slot);
+                callback(res, data);
+            } else {
+                op.on_data(res, data);
+            }
+        } else if (last) {
+            completion_callback callback = std::move(op.callback);
+            release_op(slot);
+            callback(res);
+        } else {
+            op.callback(res);
+        }
+        metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("multishot_callback", std::current_exception(), fd);
+    }
+}
+
+result<void> io_uring_reactor::ensure_buffer_ring() {
+    if (buf_ring_) {
+        return {};
+    }
+
+    try {
+        buf_ring_storage_ =
+            std::make_unique<uint8_t[]>(size_t{PROVIDED_BUFFER_COUNT} * PROVIDED_BUFFER_SIZE);
+    } catch (const std::bad_alloc&) {
+        return std::unexpected(std::make_error_code(std::errc::not_enough_memory));
+    }
+
+    int ret = 0;
+    buf_ring_ =
+        io_uring_setup_buf_ring(&ring_, PROVIDED_BUFFER_COUNT, PROVIDED_BUFFER_GROUP, 0, &ret);
+    if (!buf_ring_) {
+        buf_ring_storage_.reset();
         return std::unexpected(std::error_code(-ret, std::system_category()));
     }
 
+    const int mask = io_uring_buf_ring_mask(PROVIDED_BUFFER_COUNT);
+    for (uint32_t i = 0; i < PROVIDED_BUFFER_COUNT; ++i) {
+        io_uring_buf_ring_add(buf_ring_,
+                              buf_ring_storage_.get() + size_t{i} * PROVIDED_BUFFER_SIZE,
+                              PROVIDED_BUFFER_SIZE,
+                              static_cast<unsigned short>(i),
+                              mask,
+                              static_cast<int>(i));
+    }
+    io_uring_buf_ring_advance(buf_ring_, static_cast<int>(PROVIDED_BUFFER_COUNT));
     return {};
 }
 
+void io_uring_reactor::recycle_buffer(uint16_t buffer_id) noexcept {
+    io_uring_buf_ring_add(buf_ring_,
+                          buf_ring_storage_.get() + size_t{buffer_id} * PROVIDED_BUFFER_SIZE,
+                          PROVIDED_BUFFER_SIZE,
+                          buffer_id,
+                          io_uring_buf_ring_mask(PROVIDED_BUFFER_COUNT),
+                          0);
+    io_uring_buf_ring_advance(buf_ring_, 1);
+}
+
+void io_uring_reactor::dispatch_poll(uint64_t handle, int32_t res) {
+    // A stale handle is a completion for an fd that was unregistered (and maybe reused) since
+    // the poll was armed; it must not reach the new registration.
+    auto* state = fds_.resolve(handle);
+    if (!state || !state->callback) {
+        return;
+    }
+
+    const int32_t fd = fds_.fd_of(handle);
+    state->poll_armed = false;
+    if (res == -ECANCELED) {
+        return;
+    }
+
+    // The callback may unregister itself, which resets the state it is stored in, so it runs
+    // from a copy and the handle is resolved again afterwards.
+    event_callback callback_copy = state->callback;
+    if (res < 0) {
+        try {
+            callback_copy(event_type::error);
+            metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
+        } catch (...) {
+            handle_exception("fd_callback_error", std::current_exception(), fd);
+        }
+        return;
+    }
+
+    try {
+        callback_copy(from_poll_events(static_cast<uint32_t>(res)));
+        metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("fd_callback", std::current_exception(), fd);
+    }
+
+    state = fds_.resolve(handle);
+    if (state && state->registered && !state->poll_armed &&
+        !has_flag(state->events, event_type::oneshot)) {
+        if (submit_poll_add(fd, handle, state->events)) {
+            state->poll_armed = true;
+        }
+    }
+}
+
 result<void> io_uring_reactor::process_completions(int32_t timeout_ms) {
+    // Everything queued during this iteration goes out with the wait itself.
     io_uring_cqe* cqe = nullptr;
     int ret;
 
@@ -388,61 +947,66 @@ result<void> io_uring_reactor::process_completions(int32_t timeout_ms) {
         __kernel_timespec ts;
         ts.tv_sec = timeout_ms / 1000;
         ts.tv_nsec = (timeout_ms % 1000) * 1000000;
-        ret = io_uring_wait_cqe_timeout(&ring_, &cqe, &ts);
+        ret = io_uring_submit_and_wait_timeout(&ring_, &cqe, 1, &ts, nullptr);
     } else if (timeout_ms == 0) {
-        ret = io_uring_peek_cqe(&ring_, &cqe);
+        ret = io_uring_submit_and_get_events(&ring_);
     } else {
-        ret = io_uring_wait_cqe(&ring_, &cqe);
+        ret = io_uring_submit_and_wait(&ring_, 1);
     }
 
-    if (ret < 0 && ret != -ETIME && ret != -EAGAIN) {
+    if (ret < 0 && ret != -ETIME && ret != -EAGAIN && ret != -EINTR && ret != -EBUSY) {
         return std::unexpected(std::error_code(-ret, std::system_category()));
     }
 
+    unsigned head;
     unsigned count = 0;
     io_uring_cqe* current_cqe;
-    io_uring_for_each_cqe(&ring_, count, current_cqe) {
-        int32_t fd =
-            static_cast<int32_t>(reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(current_cqe)));
 
-        if (fd >= 0 && static_cast<size_t>(fd) < fd_states_.size() &&
-            fd_states_[static_cast<size_t>(fd)].callback) {
+    // Warm the fd states of the batch's poll completions, then what they point at, before
+    // running any callback (see epoll_reactor::process_events).
+    const auto poll_handle = [](const io_uring_cqe* completion) {
+        const uint64_t user_data = io_uring_cqe_get_data64(completion);
+        return static_cast<op_type>(user_data & ((1u << USER_DATA_TAG_BITS) - 1)) ==
+                       op_type::poll_add
+                   ? user_data >> USER_DATA_TAG_BITS
+                   : decltype(fds_)::INVALID_HANDLE;
+    };
+    io_uring_for_each_cqe(&ring_, head, current_cqe) {
+        fds_.prefetch(poll_handle(current_cqe));
+    }
+    io_uring_for_each_cqe(&ring_, head, current_cqe) {
+        auto* state = fds_.resolve(poll_handle(current_cqe));
+        if (state && state->prefetch_hint) {
+            __builtin_prefetch(state->prefetch_hint, 0, 1);
+        }
+    }
 
-            int res = current_cqe->res;
+    io_uring_for_each_cqe(&ring_, head, current_cqe) {
+        ++count;
+        const uint64_t user_data = io_uring_cqe_get_data64(current_cqe);
+        const int32_t res = current_cqe->res;
+        const uint64_t payload = user_data >> USER_DATA_TAG_BITS;
 
-            if (res < 0) {
-                if (res == -ECANCELED) {
-                    continue;
-                }
-                event_callback callback_copy = fd_states_[static_cast<size_t>(fd)].callback;
-                if (callback_copy) {
-                    try {
-                        callback_copy(event_type::error);
-                        metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
-                    } catch (...) {
-                        handle_exception("fd_callback_error", std::current_exception(), fd);
-                    }
-                }
-            } else {
-                event_type ev = from_poll_events(static_cast<uint32_t>(res));
-                event_callback callback_copy = fd_states_[static_cast<size_t>(fd)].callback;
-
-                if (!callback_copy) {
-                    continue;
-                }
-
-                try {
-                    callback_copy(ev);
-                    metrics_.fd_events_processed.fetch_add(1, std::memory_order_relaxed);
-                } catch (...) {
-                    handle_exception("fd_callback", std::current_exception(), fd);
-                }
-
-                if (fd_states_[static_cast<size_t>(fd)].registered &&
-                    !has_flag(fd_states_[static_cast<size_t>(fd)].events, event_type::oneshot)) {
-                    submit_poll_add(fd, fd_states_[static_cast<size_t>(fd)].events);
-                }
-            }
+        switch (static_cast<op_type>(user_data & ((1u << USER_DATA_TAG_BITS) - 1))) {
+        case op_type::poll_add:
+            dispatch_poll(payload, res);
+            break;
+        case op_type::recv:
+        case op_type::send:
+        case op_type::writev:
+            complete_op(payload, res);
+            break;
+        case op_type::accept_multishot:
+        case op_type::recv_multishot:
+            complete_multishot(payload, res, current_cqe->flags);
+            break;
+        case op_type::send_zc:
+            complete_send_zc(payload, res, current_cqe->flags);
+            break;
+        case op_type::poll_remove:
+        case op_type::cancel:
+            // Acknowledgements only; the affected requests report on their own CQEs.
+            break;
         }
     }
 
@@ -472,22 +1036,20 @@ void io_uring_reactor::process_tasks() {
 
 void io_uring_reactor::process_timers() {
     while (auto timer = pending_timers_.pop()) {
-        timers_.push(std::move(*timer));
+        wheel_timer_.add_at(timer->deadline, [this, task = std::move(timer->task)]() {
+            run_delayed_task(task);
+        });
     }
+    wheel_timer_.tick();
+}
 
-    auto now = std::chrono::steady_clock::now();
-
-    while (!timers_.empty() && timers_.top().deadline <= now) {
-        auto task = std::move(timers_.top().task);
-        timers_.pop();
-
-        try {
-            task();
-            metrics_.tasks_executed.fetch_add(1, std::memory_order_relaxed);
-            metrics_.timers_fired.fetch_add(1, std::memory_order_relaxed);
-        } catch (...) {
-            handle_exception("delayed_task", std::current_exception());
-        }
+void io_uring_reactor::run_delayed_task(const task_fn& task) {
+    try {
+        task();
+        metrics_.tasks_executed.fetch_add(1, std::memory_order_relaxed);
+        metrics_.timers_fired.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        handle_exception("delayed_task", std::current_exception());
     }
 }
 
@@ -509,16 +1071,6 @@ int32_t io_uring_reactor::calculate_timeout() const {
 
     auto min_timeout = std::chrono::milliseconds::max();
 
-    if (!timers_.empty()) {
-        auto deadline = timers_.top().deadline;
-        if (deadline <= now) {
-            timeout_dirty_.store(true, std::memory_order_relaxed);
-            return 0;
-        }
-        auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
-        min_timeout = std::min(min_timeout, delta);
-    }
-
     auto wheel_timeout = wheel_timer_.time_until_next_expiration(now);
     if (wheel_timeout == std::chrono::milliseconds::zero()) {
         timeout_dirty_.store(true, std::memory_order_relaxed);
@@ -565,11 +1117,7 @@ uint64_t io_uring_reactor::get_load_score() const noexcept {
     return active_fds * 100 + pending_tasks * 50 + pending_timers_count * 10;
 }
 
-void io_uring_reactor::process_wheel_timer() {
-    wheel_timer_.tick();
-}
-
-void io_uring_reactor::setup_fd_timeout(int32_t fd, fd_state& state) {
+void io_uring_reactor::setup_fd_timeout(uint64_t handle, fd_state& state) {
     auto timeout = fd_timeout_for(state);
 
     if (!state.activity_timer.active() || state.activity_timer.duration() != timeout) {
@@ -578,13 +1126,14 @@ void io_uring_reactor::setup_fd_timeout(int32_t fd, fd_state& state) {
         state.activity_timer.reset();
     }
 
-    state.timeout_id = wheel_timer_.add(timeout, [this, fd]() {
-        if (fd < 0 || static_cast<size_t>(fd) >= fd_states_.size()) {
+    state.timeout_id = wheel_timer_.add(timeout, [this, handle]() {
+        auto* entry = fds_.resolve(handle);
+        if (!entry) {
             return;
         }
 
-        auto index = static_cast<size_t>(fd);
-        auto& entry_state = fd_states_[index];
+        const int32_t fd = fds_.fd_of(handle);
+        auto& entry_state = *entry;
         if (!entry_state.callback) {
             entry_state.timeout_id = 0;
             entry_state.activity_timer = Timeout{};
@@ -595,8 +1144,9 @@ void io_uring_reactor::setup_fd_timeout(int32_t fd, fd_state& state) {
         entry_state.activity_timer = Timeout{};
         metrics_.fd_timeouts.fetch_add(1, std::memory_order_relaxed);
 
-        submit_poll_remove(fd);
+        submit_poll_remove(handle);
 
+        (void)unregister_file(fd);
         if (close(fd) < 0 && errno != EBADF) {
             handle_exception("timeout_close",
                              std::make_exception_ptr(
@@ -610,7 +1160,9 @@ void io_uring_reactor::setup_fd_timeout(int32_t fd, fd_state& state) {
             handle_exception("timeout_handler", std::current_exception(), fd);
         }
 
-        fd_states_[index] = fd_state{};
+        if (fds_.resolve(handle)) {
+            fds_.erase(fd);
+        }
     });
 }
 
@@ -640,32 +1192,16 @@ std::chrono::milliseconds io_uring_reactor::fd_timeout_for(const fd_state& state
     return timeout;
 }
 
-result<void> io_uring_reactor::ensure_fd_capacity(int32_t fd) {
-    if (fd < 0) {
-        return std::unexpected(make_error_code(error_code::invalid_fd));
-    }
-
-    size_t index = static_cast<size_t>(fd);
-    if (index < fd_states_.size()) {
-        return {};
+result<uint64_t> io_uring_reactor::insert_fd(int32_t fd) {
+    // Re-registering replaces the old entry; its poll completes under a now-stale handle.
+    if (auto* old = fds_.find(fd); old && old->poll_armed) {
+        (void)submit_poll_remove(fds_.handle_of(fd));
     }
-
-    size_t new_size = fd_states_.empty() ? 64 : fd_states_.size();
-    while (new_size <= index) {
-        if (new_size > fd_states_.max_size() / 2) {
-            new_size = index + 1;
-            break;
-        }
-        new_size = std::max(new_size * 2, index + 1);
-    }
-
     try {
-        fd_states_.resize(new_size);
+        return fds_.insert(fd);
     } catch (const std::bad_alloc&) {
         return std::unexpected(std::make_error_code(std::errc::not_enough_memory));
     }
-
-    return {};
 }
 
 std::chrono::milliseconds
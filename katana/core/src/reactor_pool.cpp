@@ -2,42 +2,132 @@
 #include "katana/core/cpu_info.hpp"
 
 #include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 namespace katana {
 
+namespace {
+
+thread_local const reactor_pool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // namespace
+
 reactor_pool::reactor_pool(const reactor_pool_config& config) : config_(config) {
     if (config_.reactor_count == 0) {
         config_.reactor_count = cpu_info::core_count();
     }
 
     reactors_.reserve(config_.reactor_count);
-
     for (uint32_t i = 0; i < config_.reactor_count; ++i) {
         auto ctx = std::make_unique<reactor_context>();
+        ctx->index = i;
+        ctx->core_id = i;
+        reactors_.push_back(std::move(ctx));
+    }
+    if (config_.enable_numa_placement) {
+        place_reactors(reactors_);
+    }
+
+    for (auto& ctx : reactors_) {
+        auto build = [this, &ctx]() {
+            ctx->reactor = make_reactor();
+            if (config_.enable_work_stealing) {
+                ctx->jobs = std::make_unique<work_stealing_deque<offload_job*>>();
+            }
+        };
+        if (config_.enable_numa_placement) {
+            std::thread builder([&]() {
+                (void)cpu_info::pin_thread_to_core(ctx->core_id);
+                build();
+            });
+            builder.join();
+        } else {
+            build();
+        }
+    }
+
+    const size_t pairs = reactors_.size() * reactors_.size();
+    channels_ = std::make_unique<std::atomic<spsc_channel<task_fn>*>[]>(pairs);
+    for (size_t i = 0; i < pairs; ++i) {
+        channels_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+std::unique_ptr<reactor_impl> reactor_pool::make_reactor() const {
 #if defined(KATANA_USE_IO_URING)
-        ctx->reactor = std::make_unique<reactor_impl>(reactor_impl::DEFAULT_RING_SIZE,
-                                                      config_.max_pending_tasks);
+    io_uring_setup_options options;
+    options.sqpoll = config_.io_uring_sqpoll;
+    options.sqpoll_idle_ms = config_.io_uring_sqpoll_idle_ms;
+    options.single_issuer = config_.io_uring_single_issuer;
+    options.defer_taskrun = config_.io_uring_defer_taskrun;
+    return std::make_unique<reactor_impl>(
+        reactor_impl::DEFAULT_RING_SIZE, config_.max_pending_tasks, options);
 #elif defined(KATANA_USE_EPOLL)
-        ctx->reactor = std::make_unique<reactor_impl>(config_.max_events_per_reactor,
-                                                      config_.max_pending_tasks);
+    epoll_poll_options options;
+    options.spin_budget = std::chrono::microseconds(config_.epoll_spin_budget_us);
+    options.busy_poll_usecs = config_.epoll_busy_poll_usecs;
+    options.busy_poll_budget = config_.epoll_busy_poll_budget;
+    options.prefer_busy_poll = config_.epoll_prefer_busy_poll;
+    options.writable_first = config_.epoll_writable_first;
+    return std::make_unique<reactor_impl>(
+        config_.max_events_per_reactor, config_.max_pending_tasks, options);
 #endif
-        ctx->core_id = i;
-        reactors_.push_back(std::move(ctx));
+}
+
+// Reactors go to nodes round-robin and take each node's CPUs in order, so a pool smaller than
+// the machine still uses every node's memory controller. Larger pools wrap around.
+void reactor_pool::place_reactors(std::vector<std::unique_ptr<reactor_context>>& contexts) {
+    auto nodes = cpu_info::numa_nodes();
+    std::vector<size_t> next_cpu(nodes.size(), 0);
+    size_t node = 0;
+    for (auto& ctx : contexts) {
+        for (size_t tried = 0; tried < nodes.size() && next_cpu[node] == nodes[node].cpus.size();
+             ++tried) {
+            node = (node + 1) % nodes.size();
+        }
+        if (next_cpu[node] == nodes[node].cpus.size()) {
+            std::fill(next_cpu.begin(), next_cpu.end(), 0);
+        }
+        ctx->core_id = nodes[node].cpus[next_cpu[node]++];
+        ctx->numa_node = nodes[node].id;
+        node = (node + 1) % nodes.size();
+    }
+}
+
+void reactor_pool::note_cross_node(size_t from, size_t to, uint64_t tasks) noexcept {
+    if (reactors_[from]->numa_node != reactors_[to]->numa_node) {
+        reactors_[from]->cross_node_tasks.fetch_add(tasks, std::memory_order_relaxed);
     }
 }
 
 reactor_pool::~reactor_pool() {
     stop();
     wait();
+    for (auto& ctx : reactors_) {
+        if (ctx->jobs) {
+            while (auto job = ctx->jobs->pop()) {
+                delete *job;
+            }
+        }
+        for (auto* job : ctx->stalled_completions) {
+            delete job;
+        }
+    }
+    for (size_t i = 0; i < reactors_.size() * reactors_.size(); ++i) {
+        delete channels_[i].load(std::memory_order_acquire);
+    }
 }
 
 void reactor_pool::start() {
     for (auto& ctx : reactors_) {
         ctx->running.store(true, std::memory_order_release);
+        ctx->exited.store(false, std::memory_order_release);
         ctx->thread = std::thread(&reactor_pool::worker_thread, this, ctx.get());
     }
 }
@@ -106,16 +196,247 @@ size_t reactor_pool::select_least_loaded() noexcept {
     return min_load_idx;
 }
 
+std::optional<size_t> reactor_pool::migration_target() noexcept {
+    auto self = current_reactor_index();
+    if (!self || !config_.enable_connection_migration || reactors_.size() < 2) {
+        return std::nullopt;
+    }
+
+    auto& ctx = *reactors_[*self];
+    if (ctx.migration_countdown > 0) {
+        --ctx.migration_countdown;
+        return std::nullopt;
+    }
+    ctx.migration_countdown = config_.migration_check_interval;
+
+    size_t coldest = select_least_loaded();
+    if (coldest == *self) {
+        return std::nullopt;
+    }
+    uint64_t own = ctx.reactor->get_load_score();
+    uint64_t cold = reactors_[coldest]->reactor->get_load_score();
+    // The gap keeps one move from turning the target into the new hot spot.
+    if (own < cold + config_.migration_min_load_gap ||
+        own * 100 <= cold * config_.migration_load_ratio_percent) {
+        return std::nullopt;
+    }
+
+    migrated_connections_.fetch_add(1, std::memory_order_relaxed);
+    return coldest;
+}
+
 metrics_snapshot reactor_pool::aggregate_metrics() const {
     metrics_snapshot total;
     for (const auto& ctx : reactors_) {
         total += ctx->reactor->metrics().snapshot();
+        total.cross_node_tasks += ctx->cross_node_tasks.load(std::memory_order_relaxed);
     }
     return total;
 }
 
+std::optional<size_t> reactor_pool::current_reactor_index() const noexcept {
+    if (current_pool != this) {
+        return std::nullopt;
+    }
+    return current_index;
+}
+
+bool reactor_pool::post(size_t target, task_fn task) {
+    target %= reactors_.size();
+    auto producer = current_reactor_index();
+    if (!producer) {
+        return reactors_[target]->reactor->schedule(std::move(task));
+    }
+
+    if (!channel(*producer, target).try_push(std::move(task))) {
+        return false;
+    }
+    posted_tasks_.fetch_add(1, std::memory_order_relaxed);
+    note_cross_node(*producer, target, 1);
+    request_drain(target);
+    return true;
+}
+
+size_t reactor_pool::post_batch(size_t target, std::span<task_fn> tasks) {
+    target %= reactors_.size();
+    auto producer = current_reactor_index();
+    size_t taken = 0;
+    if (!producer) {
+        auto& r = *reactors_[target]->reactor;
+        while (taken < tasks.size() && r.schedule(std::move(tasks[taken]))) {
+            ++taken;
+        }
+        return taken;
+    }
+
+    auto& ch = channel(*producer, target);
+    while (taken < tasks.size() && ch.try_push(std::move(tasks[taken]))) {
+        ++taken;
+    }
+    if (taken > 0) {
+        posted_tasks_.fetch_add(taken, std::memory_order_relaxed);
+        note_cross_node(*producer, target, taken);
+        request_drain(target);
+    }
+    return taken;
+}
+
+// Only `producer` ever creates the (producer, consumer) channel, so publishing it needs no
+// more than a release store.
+spsc_channel<task_fn>& reactor_pool::channel(size_t producer, size_t consumer) {
+    auto& slot = channels_[producer * reactors_.size() + consumer];
+    auto* ch = slot.load(std::memory_order_acquire);
+    if (!ch) {
+        ch = new spsc_channel<task_fn>(config_.post_channel_capacity);
+        slot.store(ch, std::memory_order_release);
+    }
+    return *ch;
+}
+
+// drain_scheduled is flipped with read-modify-writes on both sides: either the producer sees
+// it cleared and schedules a new drain, or the running drain sees the producer's push.
+void reactor_pool::request_drain(size_t consumer) {
+    auto& ctx = *reactors_[consumer];
+    if (ctx.drain_scheduled.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (ctx.reactor->schedule([this, consumer]() { drain_posts(consumer); })) {
+        post_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Task queue full: leave the tasks queued; the next post() retries the wakeup.
+        ctx.drain_scheduled.store(false, std::memory_order_release);
+    }
+}
+
+void reactor_pool::drain_posts(size_t consumer) {
+    reactors_[consumer]->drain_scheduled.exchange(false, std::memory_order_acq_rel);
+
+    // At most one channel's worth per producer, so a busy producer cannot starve I/O; anything
+    // pushed after the flag was cleared has scheduled another drain.
+    task_fn task;
+    for (size_t producer = 0; producer < reactors_.size(); ++producer) {
+        auto* ch =
+            channels_[producer * reactors_.size() + consumer].load(std::memory_order_acquire);
+        if (!ch) {
+            continue;
+        }
+        for (size_t i = 0; i < ch->capacity() && ch->try_pop(task); ++i) {
+            try {
+                task();
+            } catch (...) {
+                request_drain(consumer);
+                throw;
+            }
+        }
+    }
+}
+
+// Every queued job is matched by one steal request sent after it, and a request runs at most
+// one job, so no job is left behind once all requests have run. The request goes to the
+// least loaded other reactor; the owner only runs its own jobs if nobody else can.
+void reactor_pool::submit_job(offload_job* job) {
+    const size_t owner = job->owner;
+    reactors_[owner]->jobs->push(job);
+    offloaded_jobs_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t target = owner;
+    uint64_t target_load = UINT64_MAX;
+    for (size_t i = 0; i < reactors_.size(); ++i) {
+        if (i == owner) {
+            continue;
+        }
+        uint64_t load = reactors_[i]->reactor->get_load_score();
+        if (load < target_load) {
+            target_load = load;
+            target = i;
+        }
+    }
+
+    if (target != owner &&
+        reactors_[target]->reactor->schedule([this, target]() { run_offloaded(target); })) {
+        note_cross_node(owner, target, 1);
+        return;
+    }
+    if (reactors_[owner]->reactor->schedule([this, owner]() { run_offloaded(owner); })) {
+        return;
+    }
+    run_offloaded(owner);
+}
+
+void reactor_pool::run_offloaded(size_t thief) {
+    retry_stalled(thief);
+
+    // Victims on the thief's own node go first: their job's captures are local memory.
+    std::optional<offload_job*> job = reactors_[thief]->jobs->pop();
+    for (int pass = 0; !job && pass < 2; ++pass) {
+        for (size_t i = 1; !job && i < reactors_.size(); ++i) {
+            size_t victim = (thief + i) % reactors_.size();
+            bool same_node = reactors_[victim]->numa_node == reactors_[thief]->numa_node;
+            if (same_node != (pass == 0)) {
+                continue;
+            }
+            job = reactors_[victim]->jobs->steal();
+            if (job) {
+                stolen_jobs_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    if (!job) {
+        return;
+    }
+
+    (*job)->run();
+    if ((*job)->owner == thief) {
+        std::unique_ptr<offload_job> owned(*job);
+        owned->resume();
+        return;
+    }
+    note_cross_node(thief, (*job)->owner, 1);
+    complete_job(*job, thief);
+}
+
+void reactor_pool::complete_job(offload_job* job, size_t thief) {
+    auto& owner = *reactors_[job->owner];
+    auto& self = *reactors_[thief];
+    auto resume = [job]() {
+        std::unique_ptr<offload_job> owned(job);
+        owned->resume();
+    };
+    auto retry = [this, job, thief]() { complete_job(job, thief); };
+
+    if (owner.reactor->schedule(resume)) {
+        return;
+    }
+    // A stopping owner still runs tasks while it drains; only one whose loop has returned
+    // never will.
+    if (owner.exited.load(std::memory_order_acquire)) {
+        delete job;
+        return;
+    }
+    // The owner's task queue is bounded and resume() must not run here. When it is full, the
+    // thief retries from its next loop iteration, serving its own fds in between, or after a
+    // tick if its task queue is full as well. If even that is full, the job waits for the
+    // thief's next offload work rather than spinning here.
+    if (!self.reactor->schedule(retry) &&
+        !self.reactor->schedule_after(std::chrono::milliseconds(1), retry)) {
+        self.stalled_completions.push_back(job);
+    }
+}
+
+void reactor_pool::retry_stalled(size_t thief) {
+    auto stalled = std::move(reactors_[thief]->stalled_completions);
+    reactors_[thief]->stalled_completions.clear();
+    for (auto* job : stalled) {
+        complete_job(job, thief);
+    }
+}
+
 void reactor_pool::worker_thread(reactor_context* ctx) {
-    if (config_.enable_thread_pinning) {
+    current_pool = this;
+    current_index = ctx->index;
+
+    if (config_.enable_thread_pinning || config_.enable_cpu_steering ||
+        config_.enable_numa_placement) {
         if (!cpu_info::pin_thread_to_core(ctx->core_id)) {
             std::cerr << "[reactor_pool] Warning: Failed to pin thread to core " << ctx->core_id
                       << "\n";
@@ -126,6 +447,7 @@ void reactor_pool::worker_thread(reactor_context* ctx) {
     if (!result) {
         std::cerr << "[reactor_pool] Reactor error: " << result.error().message() << "\n";
     }
+    ctx->exited.store(true, std::memory_order_release);
 }
 
 int32_t reactor_pool::create_listener_socket_reuseport(uint16_t port) {
@@ -156,4 +478,35 @@ int32_t reactor_pool::create_listener_socket_reuseport(uint16_t port) {
     return fd;
 }
 
+// Listeners join the reuseport group in reactor order, so the index the program returns is
+// the listener of the reactor pinned to that CPU. One attach covers the whole group.
+void reactor_pool::steer_listeners_by_cpu() noexcept {
+    if (!config_.enable_cpu_steering || reactors_.empty() || reactors_[0]->listener_fd < 0) {
+        return;
+    }
+
+    // A = cpu; one compare-and-return per reactor, then cpu % reactor_count.
+    constexpr auto cpu_offset = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU);
+    std::vector<sock_filter> code;
+    code.push_back({BPF_LD | BPF_W | BPF_ABS, 0, 0, cpu_offset});
+    if (2 * reactors_.size() + 3 <= BPF_MAXINSNS) {
+        for (const auto& ctx : reactors_) {
+            code.push_back({BPF_JMP | BPF_JEQ | BPF_K, 0, 1, ctx->core_id});
+            code.push_back({BPF_RET | BPF_K, 0, 0, ctx->index});
+        }
+    }
+    code.push_back({BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(reactors_.size())});
+    code.push_back({BPF_RET | BPF_A, 0, 0, 0});
+
+    sock_fprog prog{static_cast<unsigned short>(code.size()), code.data()};
+    if (setsockopt(reactors_[0]->listener_fd,
+                   SOL_SOCKET,
+                   SO_ATTACH_REUSEPORT_CBPF,
+                   &prog,
+                   sizeof(prog)) < 0) {
+        std::cerr << "[reactor_pool] Warning: Failed to attach CPU steering program: "
+                  << std::strerror(errno) << "\n";
+    }
+}
+
 } // namespace katana
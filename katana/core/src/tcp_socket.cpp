@@ -2,6 +2,10 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <system_error>
 #include <unistd.h>
 
@@ -67,6 +71,99 @@ result<size_t> tcp_socket::write(std::span<const uint8_t> data) {
     return total_written;
 }
 
+result<size_t> tcp_socket::write_zerocopy(std::span<const uint8_t> data) {
+    if (fd_ < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+
+    if (zerocopy_copied_) {
+        return write(data);
+    }
+    if (!zerocopy_) {
+        int one = 1;
+        if (::setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) != 0) {
+            return write(data);
+        }
+        zerocopy_ = true;
+    }
+
+    size_t total_written = 0;
+    while (total_written < data.size()) {
+        ssize_t n = ::send(fd_,
+                           data.data() + total_written,
+                           data.size() - total_written,
+                           MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return total_written;
+            }
+            if (errno == ENOBUFS) {
+                // Out of optmem for pinned pages; this chunk goes through the copy path.
+                auto copied = write(data.subspan(total_written));
+                if (!copied) {
+                    return copied;
+                }
+                return total_written + *copied;
+            }
+            return std::unexpected(std::error_code(errno, std::system_category()));
+        }
+
+        ++zerocopy_sent_;
+        total_written += static_cast<size_t>(n);
+    }
+
+    return total_written;
+}
+
+result<uint32_t> tcp_socket::reap_zerocopy() {
+    if (fd_ < 0) {
+        return std::unexpected(make_error_code(error_code::invalid_fd));
+    }
+    if (!zerocopy_) {
+        return zerocopy_completed_;
+    }
+
+    while (true) {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err)) + 64];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(fd_, &msg, MSG_ERRQUEUE) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return zerocopy_completed_;
+            }
+            return std::unexpected(std::error_code(errno, std::system_category()));
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            // Notifications cover the inclusive range [ee_info, ee_data] of send counters and
+            // arrive in order on TCP sockets.
+            zerocopy_completed_ = err.ee_data + 1;
+            // The kernel copied the pages after all: pinning them only added the notification
+            // round trip, and this route will not get better for the socket's lifetime.
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                zerocopy_copied_ = true;
+            }
+        }
+    }
+}
+
 void tcp_socket::close() noexcept {
     if (fd_ >= 0) {
         ::close(fd_);
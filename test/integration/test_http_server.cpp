@@ -1,11 +1,17 @@
 #include "katana/core/arena.hpp"
 #include "katana/core/http.hpp"
+#include "katana/core/http_server.hpp"
 #include "katana/core/reactor_pool.hpp"
 
 #include <arpa/inet.h>
+#include <atomic>
 #include <chrono>
 #include <gtest/gtest.h>
+#include <malloc.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <string>
 #include <sys/socket.h>
 #include <thread>
 #include <unistd.h>
@@ -14,6 +20,86 @@ using namespace katana;
 
 constexpr uint16_t TEST_PORT = 9999;
 
+namespace {
+
+// Runs an http::server with one worker on `port` until the object goes out of scope.
+class running_server {
+public:
+    running_server(const http::router& rt, uint16_t port) : server_(rt) {
+        server_.listen(port).workers(1).graceful_shutdown(std::chrono::milliseconds(100));
+        server_.on_start([this]() { started_.store(true, std::memory_order_release); });
+        thread_ = std::thread([this]() { server_.run(); });
+        while (!started_.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    ~running_server() {
+        shutdown_manager::instance().trigger_shutdown();
+        thread_.join();
+    }
+
+private:
+    http::server server_;
+    std::atomic<bool> started_{false};
+    std::thread thread_;
+};
+
+int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(port);
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (connect(fd, static_cast<sockaddr*>(static_cast<void*>(&addr)), sizeof(addr)) == 0) {
+            return fd;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    close(fd);
+    return -1;
+}
+
+bool send_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Reads one Content-Length response and returns its body.
+std::string read_body(int fd) {
+    std::string in;
+    char chunk[4096];
+    size_t head_end = std::string::npos;
+    size_t length = 0;
+    while (head_end == std::string::npos || in.size() < head_end + length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return {};
+        }
+        in.append(chunk, static_cast<size_t>(n));
+        if (head_end == std::string::npos && (head_end = in.find("\r\n\r\n")) != in.npos) {
+            head_end += 4;
+            size_t at = in.find("Content-Length: ");
+            length = at < head_end ? std::stoul(in.substr(at + 16)) : 0;
+        }
+    }
+    return in.substr(head_end, length);
+}
+
+size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+} // namespace
+
 class HTTPServerTest : public ::testing::Test {
 protected:
     void SetUp() override {
@@ -112,3 +198,86 @@ TEST_F(HTTPServerTest, ArenaAllocation) {
     arena.reset();
     EXPECT_EQ(arena.bytes_allocated(), 0);
 }
+
+TEST(HTTPServerConnection, LargeBodyStorageIsReleasedWhileIdle) {
+    static const http::route_entry routes[] = {
+        {http::method::post,
+         http::path_pattern::from_literal<"/upload">(),
+         http::handler_fn([](const http::request& req, http::request_context&) {
+             return http::response::ok(std::to_string(req.body.size()));
+         })},
+    };
+    http::router rt(routes);
+    running_server server(rt, 18401);
+
+    int fd = connect_to(18401);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(send_all(fd, "POST /upload HTTP/1.1\r\nContent-Length: 2\r\n\r\nok"));
+    EXPECT_EQ(read_body(fd), "2");
+    const size_t before = heap_in_use();
+
+    constexpr size_t body_size = 8 * 1024 * 1024;
+    {
+        std::string request = "POST /upload HTTP/1.1\r\nContent-Length: " +
+                              std::to_string(body_size) + "\r\n\r\n";
+        request.append(body_size, 'x');
+        ASSERT_TRUE(send_all(fd, request));
+    }
+    EXPECT_EQ(read_body(fd), std::to_string(body_size));
+
+    // The connection stays open and idle; the server must not keep the body's buffer.
+    EXPECT_LT(heap_in_use(), before + 1024 * 1024);
+    close(fd);
+}
+
+TEST(HTTPServerConnection, PipelinedRequestsStopBeingReadWhileResponsesBackUp) {
+    static const http::route_entry routes[] = {
+        {http::method::get,
+         http::path_pattern::from_literal<"/big">(),
+         http::handler_fn([](const http::request&, http::request_context&) {
+             return http::response::ok(std::string(64 * 1024, 'b'));
+         })},
+    };
+    http::router rt(routes);
+    running_server server(rt, 18402);
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int rcvbuf = 4096;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(18402);
+    ASSERT_EQ(connect(fd, static_cast<sockaddr*>(static_cast<void*>(&addr)), sizeof(addr)), 0);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    // Nothing is read back, so the responses fill the socket and a send stays pending. Past
+    // that the server must stop taking requests in: once its buffer, the kernel's socket
+    // buffers and the window are full, the client's writes block.
+    std::string batch;
+    while (batch.size() < 64 * 1024) {
+        batch += "GET /big HTTP/1.1\r\n\r\n";
+    }
+    const size_t limit = 8 * http::MAX_BUFFER_SIZE;
+    size_t written = 0;
+    size_t offset = 0;
+    while (written < limit) {
+        pollfd pfd{fd, POLLOUT, 0};
+        if (poll(&pfd, 1, 300) <= 0) {
+            break;
+        }
+        ssize_t n = send(fd, batch.data() + offset, batch.size() - offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            ASSERT_EQ(errno, EAGAIN);
+            continue;
+        }
+        written += static_cast<size_t>(n);
+        offset = (offset + static_cast<size_t>(n)) % batch.size();
+    }
+    EXPECT_LT(written, limit);
+
+    // Reading the responses lets the server pick the connection up again.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    EXPECT_EQ(read_body(fd).size(), 64 * 1024);
+    close(fd);
+}
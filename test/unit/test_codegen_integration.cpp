@@ -205,6 +205,102 @@ paths:
     EXPECT_NE(router_content.find("getUser"), std::string::npos);
 }
 
+TEST_F(CodegenIntegrationTest, GeneratesPerfectHashRouteLookup) {
+    const char* spec = R"(
+openapi: 3.0.0
+info:
+  title: Test API
+  version: 1.0.0
+paths:
+  /api/v1/users/{id}:
+    get:
+      operationId: getUser
+      responses:
+        '200':
+          description: OK
+  /api/v1/users/me:
+    get:
+      operationId: getMe
+      responses:
+        '200':
+          description: OK
+  /api/v1/orders:
+    post:
+      operationId: createOrder
+      responses:
+        '201':
+          description: Created
+  /api/v1/orders/{id}:
+    get:
+      operationId: getOrder
+      responses:
+        '200':
+          description: OK
+)";
+
+    create_openapi_spec("test.yaml", spec);
+    ASSERT_TRUE(run_codegen("test.yaml", "all"));
+
+    auto routes = read_generated_file("generated_routes.hpp");
+    // The shared /api/v1 prefix is skipped: routes are keyed on their third segment.
+    EXPECT_NE(routes.find("key_position = 2;"), std::string::npos);
+    EXPECT_NE(routes.find("\"users\","), std::string::npos);
+    EXPECT_NE(routes.find("\"orders\","), std::string::npos);
+    // Within a bucket the literal route is tried before the parameter one.
+    auto me = routes.find("segments[3] == \"me\") hit(1, katana::http::method::get);");
+    auto by_id = routes.find("hit(0, katana::http::method::get);");
+    ASSERT_NE(me, std::string::npos);
+    ASSERT_NE(by_id, std::string::npos);
+    EXPECT_LT(me, by_id);
+
+    auto bindings = read_generated_file("generated_router_bindings.hpp");
+    EXPECT_NE(bindings.find("router_instance(route_entries, &find_route)"), std::string::npos);
+}
+
+TEST_F(CodegenIntegrationTest, DeclaresTypedPathParams) {
+    const char* spec = R"(
+openapi: 3.0.0
+info:
+  title: Test API
+  version: 1.0.0
+paths:
+  /orders/{orderId}/items/{itemId}:
+    get:
+      operationId: getItem
+      parameters:
+        - name: orderId
+          in: path
+          required: true
+          schema:
+            type: string
+            format: uuid
+        - name: itemId
+          in: path
+          required: true
+          schema:
+            type: integer
+      responses:
+        '200':
+          description: OK
+)";
+
+    create_openapi_spec("test.yaml", spec);
+    ASSERT_TRUE(run_codegen("test.yaml", "all"));
+
+    auto bindings = read_generated_file("generated_router_bindings.hpp");
+    EXPECT_NE(bindings.find("from_literal<\"/orders/{orderId:uuid}/items/{itemId:int64}\">"),
+              std::string::npos);
+    EXPECT_NE(bindings.find("int64_t itemId = ctx.params.int64_at(1);"), std::string::npos);
+    EXPECT_NE(bindings.find("p_orderId = ctx.params.at(0);"), std::string::npos);
+    EXPECT_EQ(bindings.find("ctx.params.get("), std::string::npos);
+
+    auto routes = read_generated_file("generated_routes.hpp");
+    EXPECT_NE(routes.find("valid_path_param(katana::http::param_type::uuid, segments[1])"),
+              std::string::npos);
+    EXPECT_NE(routes.find("valid_path_param(katana::http::param_type::int64, segments[3])"),
+              std::string::npos);
+}
+
 TEST_F(CodegenIntegrationTest, ValidatesArrayConstraints) {
     const char* spec = R"(
 openapi: 3.0.0
@@ -0,0 +1,76 @@
+#include "katana/core/fd_table.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace katana;
+
+namespace {
+
+struct test_state {
+    int value = 0;
+};
+
+} // namespace
+
+TEST(FdTable, InsertFindErase) {
+    fd_table<test_state> table;
+
+    auto handle = table.insert(7);
+    ASSERT_NE(table.find(7), nullptr);
+    EXPECT_EQ(table.resolve(handle), table.find(7));
+    EXPECT_EQ(table.handle_of(7), handle);
+    EXPECT_EQ(table.fd_of(handle), 7);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.find(8), nullptr);
+    EXPECT_EQ(table.find(-1), nullptr);
+
+    table.find(7)->value = 42;
+    EXPECT_TRUE(table.erase(7));
+    EXPECT_FALSE(table.erase(7));
+    EXPECT_EQ(table.find(7), nullptr);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(FdTable, StaleHandleDoesNotResolveAfterReuse) {
+    fd_table<test_state> table;
+
+    auto old_handle = table.insert(5);
+    table.find(5)->value = 1;
+    table.erase(5);
+
+    // Same fd number, same slot, new generation.
+    auto new_handle = table.insert(5);
+    EXPECT_NE(old_handle, new_handle);
+    EXPECT_EQ(static_cast<uint32_t>(old_handle), static_cast<uint32_t>(new_handle));
+    EXPECT_EQ(table.resolve(old_handle), nullptr);
+    ASSERT_NE(table.resolve(new_handle), nullptr);
+    EXPECT_EQ(table.resolve(new_handle)->value, 0);
+
+    EXPECT_EQ(table.resolve(fd_table<test_state>::INVALID_HANDLE), nullptr);
+    EXPECT_LT(new_handle >> 56, 1u);
+}
+
+TEST(FdTable, SparseFdsUseFewSlotsAndStatesStayPut) {
+    fd_table<test_state> table;
+
+    auto first = table.insert(100000);
+    auto* first_state = table.resolve(first);
+    for (int32_t fd = 0; fd < 200; ++fd) {
+        table.insert(fd);
+    }
+
+    EXPECT_EQ(table.resolve(first), first_state);
+    EXPECT_EQ(table.size(), 201u);
+    EXPECT_LE(table.capacity(), 256u);
+
+    std::vector<int32_t> seen;
+    table.for_each([&](int32_t fd, test_state&) {
+        seen.push_back(fd);
+        if (fd % 2 == 0) {
+            table.erase(fd);
+        }
+    });
+    EXPECT_EQ(seen.size(), 201u);
+    EXPECT_EQ(table.size(), 100u);
+}
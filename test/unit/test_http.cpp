@@ -1,7 +1,12 @@
 #include "katana/core/arena.hpp"
+#include "katana/core/buffer_pool.hpp"
 #include "katana/core/http.hpp"
+#include "katana/core/io_buffer.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <string>
 
 using namespace katana;
 using namespace katana::http;
@@ -269,6 +274,26 @@ TEST(HttpResponse, SerializeOk) {
     EXPECT_TRUE(serialized.find("Hello, World!") != std::string::npos);
 }
 
+TEST(HttpResponse, AppendHeadOmitsBody) {
+    auto resp = response::ok("Hello, World!", "text/plain");
+    std::string head = "prefix";
+    resp.append_head_to(head);
+
+    EXPECT_TRUE(head.starts_with("prefix"));
+    EXPECT_EQ(head.substr(6) + resp.body, resp.serialize());
+    EXPECT_TRUE(head.ends_with("\r\n\r\n"));
+}
+
+TEST(HttpResponse, MovedResponseAcceptsHeaders) {
+    auto source = response::ok("body");
+    response resp(std::move(source));
+    resp.set_header("Connection", "close");
+
+    std::string serialized = resp.serialize();
+    EXPECT_TRUE(serialized.find("Content-Length: 4") != std::string::npos);
+    EXPECT_TRUE(serialized.find("Connection: close") != std::string::npos);
+}
+
 TEST(HttpResponse, SerializeJson) {
     auto resp = response::json("{\"status\":\"ok\"}");
     std::string serialized = resp.serialize();
@@ -519,6 +544,24 @@ TEST(HttpParser, ExcessiveHeaderCount) {
     EXPECT_FALSE(result.has_value());
 }
 
+TEST(HttpParser, PipelinedRequestsDoNotCountAsHeaders) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    const std::string single = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::string request;
+    for (int i = 0; i < 150; ++i) {
+        request += single;
+    }
+
+    auto data = as_bytes(request);
+    auto result = p.parse(data);
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, parser::state::complete);
+    EXPECT_EQ(p.bytes_parsed(), single.size());
+}
+
 TEST(HttpParser, ExcessivelyLongURI) {
     monotonic_arena arena;
     parser p(&arena);
@@ -669,6 +712,254 @@ TEST(HttpParser, LargeValidContentLength) {
     EXPECT_EQ(p.get_request().body.size(), 1024 * 1024);
 }
 
+TEST(HttpParser, BufferStartsSmallAndGrowsWithBody) {
+    monotonic_arena arena;
+    parser p(&arena);
+    EXPECT_EQ(p.buffer_capacity(), 0);
+
+    std::string head = "POST / HTTP/1.1\r\nHost: example.com\r\nContent-Length: 100000\r\n\r\n";
+    ASSERT_TRUE(p.parse(as_bytes(head)).has_value());
+    EXPECT_EQ(p.buffer_capacity(), parser::INITIAL_BUFFER_SIZE);
+
+    std::string body(100000, 'x');
+    auto result = p.parse(as_bytes(body));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, parser::state::complete);
+    EXPECT_EQ(p.get_request().body, body);
+    EXPECT_GE(p.buffer_capacity(), head.size() + body.size());
+    EXPECT_LT(p.buffer_capacity(), 2 * (head.size() + body.size()));
+}
+
+TEST(HttpParser, ResetReturnsBufferToPool) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string request =
+        "POST / HTTP/1.1\r\nHost: example.com\r\nContent-Length: 200000\r\n\r\n" +
+        std::string(200000, 'x');
+    ASSERT_TRUE(p.parse(as_bytes(request)).has_value());
+    size_t capacity = p.buffer_capacity();
+
+    size_t cached = buffer_pool::local().cached_bytes();
+    arena.reset();
+    p.reset(&arena);
+    EXPECT_EQ(p.buffer_capacity(), 0);
+    EXPECT_EQ(buffer_pool::local().cached_bytes(), cached + capacity);
+
+    // The next request of the same size reuses the cached block.
+    ASSERT_TRUE(p.parse(as_bytes(request)).has_value());
+    EXPECT_EQ(buffer_pool::local().cached_bytes(), cached);
+}
+
+TEST(HttpParser, ChunkedBodyGrowsAcrossChunks) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string chunk(5000, 'y');
+    std::string request =
+        "POST / HTTP/1.1\r\nHost: example.com\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (int i = 0; i < 4; ++i) {
+        request += "1388\r\n" + chunk + "\r\n";
+    }
+    request += "0\r\n\r\n";
+
+    auto result = p.parse(as_bytes(request));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, parser::state::complete);
+    EXPECT_EQ(p.get_request().body.size(), 4 * chunk.size());
+    EXPECT_EQ(p.get_request().body.find_first_not_of('y'), std::string_view::npos);
+    // The reassembled body is not taken from the connection's arena...
+    EXPECT_LT(arena.bytes_allocated(), chunk.size());
+
+    // ...and its block goes back to the pool on reset.
+    size_t cached = buffer_pool::local().cached_bytes();
+    p.reset(&arena);
+    EXPECT_GE(buffer_pool::local().cached_bytes(),
+              cached + buffer_pool::block_size_for(4 * chunk.size()));
+}
+
+TEST(HttpParser, ParseInPlaceReturnsViewsIntoInput) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string request = "POST /items?id=7 HTTP/1.1\r\nHost: example.com\r\n"
+                          "X-Trace: abc\r\nContent-Length: 5\r\n\r\nhello";
+    auto result = p.parse_in_place(as_bytes(request));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, parser::state::complete);
+    EXPECT_EQ(p.buffer_capacity(), 0);
+
+    const auto& req = p.get_request();
+    auto inside = [&](std::string_view v) {
+        return v.data() >= request.data() && v.data() + v.size() <= request.data() + request.size();
+    };
+    EXPECT_EQ(req.uri, "/items?id=7");
+    EXPECT_TRUE(inside(req.uri));
+    EXPECT_EQ(req.body, "hello");
+    EXPECT_TRUE(inside(req.body));
+    ASSERT_TRUE(req.header("Host").has_value());
+    EXPECT_TRUE(inside(*req.header("Host")));
+    ASSERT_TRUE(req.header("X-Trace").has_value());
+    EXPECT_EQ(*req.header("X-Trace"), "abc");
+    EXPECT_TRUE(inside(*req.header("X-Trace")));
+    EXPECT_EQ(p.bytes_parsed(), request.size());
+}
+
+TEST(HttpParser, ParseInPlaceContinuesAndRestartsWhenInputMoves) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string request = "GET /a HTTP/1.1\r\nHost: example.com\r\nAccept: */*\r\n\r\n";
+    std::string buffer = request;
+    std::span<const uint8_t> all = as_bytes(buffer);
+
+    auto partial = p.parse_in_place(all.first(20));
+    ASSERT_TRUE(partial.has_value());
+    EXPECT_NE(*partial, parser::state::complete);
+
+    auto done = p.parse_in_place(all);
+    ASSERT_TRUE(done.has_value());
+    EXPECT_EQ(*done, parser::state::complete);
+    EXPECT_EQ(p.get_request().uri, "/a");
+
+    // Same bytes at a new address: the parser starts over and the views follow the new copy.
+    std::string moved = request;
+    auto again = p.parse_in_place(as_bytes(moved));
+    ASSERT_TRUE(again.has_value());
+    EXPECT_EQ(*again, parser::state::complete);
+    EXPECT_EQ(p.get_request().uri.data(), moved.data() + 4);
+    EXPECT_EQ(p.get_request().header("Accept").value_or(""), "*/*");
+}
+
+TEST(HttpParser, ParseInPlaceRejectsMixingWithCopyingParse) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string head = "GET / HTTP/1.1\r\n";
+    ASSERT_TRUE(p.parse(as_bytes(head)).has_value());
+    EXPECT_FALSE(p.parse_in_place(as_bytes(head)).has_value());
+
+    p.reset(&arena);
+    std::string request = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    ASSERT_TRUE(p.parse_in_place(as_bytes(request)).has_value());
+    EXPECT_FALSE(p.parse(as_bytes(request)).has_value());
+}
+
+TEST(HttpParser, HeadArrivingByteByByte) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string request = "GET /slow HTTP/1.1\r\nHost: example.com\r\n"
+                          "X-A-Rather-Long-Header-Name-Over-A-Vector: some value\r\n\r\n";
+    for (size_t i = 0; i + 1 < request.size(); ++i) {
+        auto step = p.parse(as_bytes(std::string_view(request).substr(i, 1)));
+        ASSERT_TRUE(step.has_value());
+        EXPECT_NE(*step, parser::state::complete);
+    }
+    auto last = p.parse(as_bytes(std::string_view(request).substr(request.size() - 1)));
+    ASSERT_TRUE(last.has_value());
+    EXPECT_EQ(*last, parser::state::complete);
+    EXPECT_EQ(p.get_request().uri, "/slow");
+    EXPECT_EQ(p.get_request().header("X-A-Rather-Long-Header-Name-Over-A-Vector").value_or(""),
+              "some value");
+}
+
+// The server's loop: bytes land in the connection's io_buffer and the parser resumes over the
+// whole unconsumed span, reset only after a complete request is consumed.
+TEST(HttpParser, InPlaceHeadByteByByteIsScannedLinearly) {
+    // Feeds a head one byte at a time, as a slow client would, and returns the best of a few
+    // runs. Resuming the scan keeps this linear in the head size; restarting it per read
+    // would make it quadratic.
+    auto byte_by_byte = [](size_t header_lines) {
+        std::string request = "GET /slow HTTP/1.1\r\nHost: example.com\r\n";
+        for (size_t i = 0; i < header_lines; ++i) {
+            std::string line = "X-Header-" + std::to_string(i) + ": ";
+            line.append(78 - line.size(), 'v');
+            request += line + "\r\n";
+        }
+        request += "\r\n";
+
+        auto best = std::chrono::steady_clock::duration::max();
+        for (int run = 0; run < 5; ++run) {
+            monotonic_arena arena;
+            parser p(&arena);
+            io_buffer buffer;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < request.size(); ++i) {
+                buffer.append(std::string_view(request).substr(i, 1));
+                auto step = p.parse_in_place(buffer.readable_span());
+                EXPECT_TRUE(step.has_value());
+                EXPECT_EQ(*step == parser::state::complete, i + 1 == request.size());
+            }
+            best = std::min(best, std::chrono::steady_clock::now() - start);
+            EXPECT_EQ(p.get_request().uri, "/slow");
+            EXPECT_EQ(p.bytes_parsed(), request.size());
+        }
+        return static_cast<double>(best.count());
+    };
+
+    // Eight times the bytes: about 8x the time when linear, about 64x when quadratic.
+    const double small = byte_by_byte(12);
+    const double large = byte_by_byte(96);
+    EXPECT_LT(large / small, 24.0);
+}
+
+TEST(HttpParser, InPlaceLimitAppliesToTheCurrentRequest) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    // A request with the largest body allowed, followed by a pipelined request: together they
+    // exceed MAX_BUFFER_SIZE, each on its own does not.
+    const std::string pad(MAX_HEADER_SIZE / 2, 'p');
+    std::string buffer = "POST /upload HTTP/1.1\r\nX-Pad: " + pad + "\r\nContent-Length: " +
+                         std::to_string(MAX_BODY_SIZE) + "\r\n\r\n";
+    buffer.append(MAX_BODY_SIZE, 'b');
+    const size_t first_size = buffer.size();
+    buffer += "GET /next HTTP/1.1\r\nX-Pad: " + pad + "\r\n\r\n";
+    ASSERT_GT(buffer.size(), MAX_BUFFER_SIZE);
+
+    auto first = p.parse_in_place(as_bytes(buffer));
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(*first, parser::state::complete);
+    EXPECT_EQ(p.bytes_parsed(), first_size);
+    EXPECT_EQ(p.get_request().body.size(), MAX_BODY_SIZE);
+
+    p.reset(&arena);
+    auto second = p.parse_in_place(as_bytes(std::string_view(buffer).substr(first_size)));
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(*second, parser::state::complete);
+    EXPECT_EQ(p.get_request().uri, "/next");
+
+    // An unfinished request may not hold more than the limit, however it is framed.
+    p.reset(&arena);
+    std::string endless = "POST /chunks HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1;";
+    endless.append(MAX_BUFFER_SIZE, 'x');
+    EXPECT_FALSE(p.parse_in_place(as_bytes(endless)).has_value());
+}
+
+TEST(HttpParser, BinaryBodyInSamePacketAsHead) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string body = {'\x00', '\x80', '\xff', '\n', '\r'};
+    std::string request =
+        "POST / HTTP/1.1\r\nHost: example.com\r\nContent-Length: 5\r\n\r\n" + body;
+    auto result = p.parse(as_bytes(request));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, parser::state::complete);
+    EXPECT_EQ(p.get_request().body, body);
+}
+
+TEST(HttpParser, ControlCharacterInLongHeaderLine) {
+    monotonic_arena arena;
+    parser p(&arena);
+
+    std::string value(70, 'v');
+    value[50] = '\x01';
+    std::string request = "GET / HTTP/1.1\r\nHost: example.com\r\nX-Long: " + value + "\r\n\r\n";
+    EXPECT_FALSE(p.parse(as_bytes(request)).has_value());
+}
+
 TEST(HttpParser, CaseInsensitiveHeaders) {
     monotonic_arena arena;
     parser p(&arena);
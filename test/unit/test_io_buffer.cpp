@@ -126,6 +126,22 @@ TEST(IOBuffer, LargeBuffer) {
     EXPECT_EQ(readable[1024 * 1024 - 1], 0xAB);
 }
 
+TEST(IOBuffer, ShrinkToFitReleasesEmptyBuffer) {
+    io_buffer buf(4096);
+    buf.append("pending");
+
+    buf.shrink_to_fit();
+    EXPECT_EQ(buf.capacity(), 4096);
+
+    buf.consume(buf.size());
+    buf.shrink_to_fit();
+    EXPECT_EQ(buf.capacity(), 0);
+
+    buf.append("again");
+    EXPECT_EQ(buf.size(), 5);
+    EXPECT_EQ(std::memcmp(buf.readable_span().data(), "again", 5), 0);
+}
+
 TEST(IOBuffer, Move) {
     io_buffer buf1;
     buf1.append("test data");
@@ -6,10 +6,16 @@ using reactor_impl = katana::io_uring_reactor;
 using reactor_impl = katana::epoll_reactor;
 #endif
 
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <string>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -590,6 +596,67 @@ TEST_F(ReactorTest, RegisterDuplicateFd) {
     close(pipefd[1]);
 }
 
+TEST_F(ReactorTest, EventForClosedFdDoesNotReachFdReusingItsNumber) {
+    int first[2];
+    int second[2];
+    ASSERT_EQ(pipe(first), 0);
+    ASSERT_EQ(pipe(second), 0);
+    ASSERT_EQ(write(first[1], "x", 1), 1);
+    ASSERT_EQ(write(second[1], "x", 1), 1);
+
+    // Both read ends are ready in the same batch. Whichever callback runs first closes the
+    // other read end and puts a fresh, empty pipe on its fd number; the event already queued
+    // for the old fd must not be delivered to the new registration.
+    bool swapped = false;
+    int reused_hits = 0;
+    int replacement[2] = {-1, -1};
+    auto swap_out = [&](int victim) {
+        if (swapped) {
+            return;
+        }
+        swapped = true;
+        reactor_->unregister_fd(victim);
+        ASSERT_EQ(pipe(replacement), 0);
+        ASSERT_EQ(dup2(replacement[0], victim), victim);
+        close(replacement[0]);
+        replacement[0] = victim;
+        reactor_->register_fd(victim, katana::event_type::readable, [&](katana::event_type) {
+            ++reused_hits;
+        });
+    };
+    auto drain = [](int fd) {
+        char buf[8];
+        (void)read(fd, buf, sizeof(buf));
+    };
+
+    ASSERT_TRUE(reactor_
+                    ->register_fd(first[0],
+                                  katana::event_type::readable,
+                                  [&](katana::event_type) {
+                                      drain(first[0]);
+                                      swap_out(second[0]);
+                                  })
+                    .has_value());
+    ASSERT_TRUE(reactor_
+                    ->register_fd(second[0],
+                                  katana::event_type::readable,
+                                  [&](katana::event_type) {
+                                      drain(second[0]);
+                                      swap_out(first[0]);
+                                  })
+                    .has_value());
+    reactor_->schedule_after(50ms, [this]() { reactor_->stop(); });
+
+    EXPECT_TRUE(reactor_->run().has_value());
+    EXPECT_TRUE(swapped);
+    EXPECT_EQ(reused_hits, 0);
+
+    for (int fd : {first[0], first[1], second[0], second[1], replacement[1]}) {
+        (void)reactor_->unregister_fd(fd);
+        close(fd);
+    }
+}
+
 TEST_F(ReactorTest, RefreshTimeoutNonExistentFd) {
     // refresh_fd_timeout returns void, so just verify it doesn't crash
     EXPECT_NO_THROW(reactor_->refresh_fd_timeout(999));
@@ -727,3 +794,286 @@ TEST_F(ReactorTest, ScheduleAfterMultiple) {
         EXPECT_TRUE(e);
     }
 }
+
+#ifdef KATANA_USE_IO_URING
+#include <sys/socket.h>
+
+TEST_F(ReactorTest, CompletionRecvSend) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    const std::string payload = "ping";
+    std::array<uint8_t, 16> rx{};
+    int32_t sent = 0;
+    int32_t received = 0;
+
+    auto send_res = reactor_->submit_send(
+        sv[0],
+        std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()),
+        [&sent](int32_t res) { sent = res; });
+    ASSERT_TRUE(send_res.has_value());
+
+    auto recv_res = reactor_->submit_recv(sv[1], rx, [&received, this](int32_t res) {
+        received = res;
+        reactor_->stop();
+    });
+    ASSERT_TRUE(recv_res.has_value());
+
+    reactor_->run();
+
+    EXPECT_EQ(sent, static_cast<int32_t>(payload.size()));
+    ASSERT_EQ(received, static_cast<int32_t>(payload.size()));
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(rx.data()), payload.size()), payload);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST_F(ReactorTest, CancelOpsCompletesWithEcanceled) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    std::array<uint8_t, 16> rx{};
+    int32_t received = 0;
+
+    ASSERT_TRUE(reactor_
+                    ->submit_recv(sv[1],
+                                  rx,
+                                  [&received, this](int32_t res) {
+                                      received = res;
+                                      reactor_->stop();
+                                  })
+                    .has_value());
+    reactor_->schedule([this, fd = sv[1]]() { (void)reactor_->cancel_ops(fd); });
+
+    reactor_->run();
+
+    EXPECT_EQ(received, -ECANCELED);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST_F(ReactorTest, CancelRecvLeavesSendsAlone) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    const std::string payload = "pong";
+    int32_t final_res = 1;
+    int32_t sent = 0;
+
+    ASSERT_TRUE(reactor_
+                    ->submit_multishot_recv(sv[1],
+                                            [&final_res, &sent, this](int32_t n,
+                                                                      std::span<const uint8_t>) {
+                                                if (n <= 0) {
+                                                    final_res = n;
+                                                    if (sent != 0) {
+                                                        reactor_->stop();
+                                                    }
+                                                }
+                                            })
+                    .has_value());
+    reactor_->schedule([this, &payload, &final_res, &sent, fd = sv[1]]() {
+        (void)reactor_->submit_send(
+            fd,
+            std::span(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()),
+            [&final_res, &sent, this](int32_t res) {
+                sent = res;
+                if (final_res != 1) {
+                    reactor_->stop();
+                }
+            });
+        (void)reactor_->cancel_recv(fd);
+    });
+
+    reactor_->run();
+
+    EXPECT_EQ(final_res, -ECANCELED);
+    EXPECT_EQ(sent, static_cast<int32_t>(payload.size()));
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST_F(ReactorTest, MultishotRecvStaysArmed) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    std::string received;
+    int32_t final_res = 1;
+
+    auto res = reactor_->submit_multishot_recv(
+        sv[1], [&received, &final_res, this, fd = sv[0]](int32_t n, std::span<const uint8_t> data) {
+            if (n <= 0) {
+                final_res = n;
+                reactor_->stop();
+                return;
+            }
+            received.append(reinterpret_cast<const char*>(data.data()), data.size());
+            if (received == "one") {
+                [[maybe_unused]] auto _ = write(fd, "two", 3);
+            } else if (received == "onetwo") {
+                shutdown(fd, SHUT_WR);
+            }
+        });
+    ASSERT_TRUE(res.has_value());
+
+    [[maybe_unused]] auto _ = write(sv[0], "one", 3);
+    reactor_->run();
+
+    EXPECT_EQ(received, "onetwo");
+    EXPECT_EQ(final_res, 0);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST_F(ReactorTest, FixedFileRoundTrip) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    if (!reactor_->register_file(sv[0]) || !reactor_->register_file(sv[1])) {
+        close(sv[0]);
+        close(sv[1]);
+        return; // file table registration not supported by the kernel
+    }
+
+    const std::string payload = "fixed";
+    char buffer[16] = {};
+    int32_t written = 0;
+    int32_t read = 0;
+
+    ASSERT_TRUE(reactor_
+                    ->submit_send(sv[0],
+                                  std::span(reinterpret_cast<const uint8_t*>(payload.data()),
+                                            payload.size()),
+                                  [&written](int32_t res) { written = res; })
+                    .has_value());
+    ASSERT_TRUE(reactor_
+                    ->submit_recv(sv[1],
+                                  std::span(reinterpret_cast<uint8_t*>(buffer), sizeof(buffer)),
+                                  [&read, this](int32_t res) {
+                                      read = res;
+                                      reactor_->stop();
+                                  })
+                    .has_value());
+
+    reactor_->run();
+
+    EXPECT_EQ(written, static_cast<int32_t>(payload.size()));
+    ASSERT_EQ(read, static_cast<int32_t>(payload.size()));
+    EXPECT_EQ(std::string(buffer, payload.size()), payload);
+
+    EXPECT_TRUE(reactor_->unregister_file(sv[0]).has_value());
+    EXPECT_TRUE(reactor_->unregister_file(sv[1]).has_value());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST(IoUringReactorOptions, SingleIssuerDeferTaskrunRunsOnAnotherThread) {
+    katana::io_uring_setup_options options;
+    options.single_issuer = true;
+    options.defer_taskrun = true;
+
+    std::unique_ptr<reactor_impl> reactor;
+    try {
+        reactor = std::make_unique<reactor_impl>(256, 1024, options);
+    } catch (const std::system_error&) {
+        return; // kernel predates DEFER_TASKRUN
+    }
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+
+    // Queued from the constructing thread; submitted by the reactor thread once run() starts.
+    std::array<uint8_t, 8> rx{};
+    int32_t received = 0;
+    ASSERT_TRUE(reactor
+                    ->submit_recv(sv[1],
+                                  rx,
+                                  [&received, &reactor](int32_t res) {
+                                      received = res;
+                                      reactor->stop();
+                                  })
+                    .has_value());
+    [[maybe_unused]] auto _ = write(sv[0], "x", 1);
+
+    std::thread loop([&reactor]() { (void)reactor->run(); });
+    loop.join();
+
+    EXPECT_EQ(received, 1);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+#endif
+
+#ifndef KATANA_USE_IO_URING
+TEST(EpollSpin, SpinsBeforeSleepingAndStillSeesTasks) {
+    katana::epoll_poll_options options;
+    options.spin_budget = 200us;
+    reactor_impl reactor(128, 1024, options);
+    EXPECT_FALSE(reactor.kernel_busy_poll());
+
+    std::atomic<int> executed{0};
+    std::thread loop([&reactor]() { (void)reactor.run(); });
+
+    // Tasks posted while the loop spins or sleeps both run: the eventfd is skipped only while
+    // the reactor is polling.
+    for (int i = 0; i < 50; ++i) {
+        reactor.schedule([&executed]() { ++executed; });
+        std::this_thread::sleep_for(i % 2 == 0 ? 50us : 2ms);
+    }
+    for (int i = 0; i < 200 && executed.load() < 50; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    reactor.stop();
+    loop.join();
+
+    EXPECT_EQ(executed.load(), 50);
+    auto metrics = reactor.metrics().snapshot();
+    EXPECT_GT(metrics.busy_polls, 0u);
+    EXPECT_GT(metrics.blocking_waits, 0u);
+}
+
+TEST(EpollDispatch, WritableFirstRunsWritableEventsBeforeReadableOnes) {
+    katana::epoll_poll_options options;
+    options.writable_first = true;
+    reactor_impl reactor(128, 1024, options);
+
+    int readable_pipe[2];
+    int writable_pipe[2];
+    ASSERT_EQ(pipe(readable_pipe), 0);
+    ASSERT_EQ(pipe(writable_pipe), 0);
+    ASSERT_EQ(write(readable_pipe[1], "x", 1), 1);
+
+    // The readable fd is registered (and becomes ready) first, so epoll reports it first.
+    std::vector<std::string> order;
+    auto record = [&](const char* name) {
+        order.emplace_back(name);
+        if (order.size() == 2) {
+            reactor.stop();
+        }
+    };
+    ASSERT_TRUE(reactor
+                    .register_fd(readable_pipe[0],
+                                 katana::event_type::readable,
+                                 [&](katana::event_type) { record("readable"); })
+                    .has_value());
+    ASSERT_TRUE(reactor
+                    .register_fd(writable_pipe[1],
+                                 katana::event_type::writable,
+                                 [&](katana::event_type) { record("writable"); })
+                    .has_value());
+    reactor.set_fd_prefetch_hint(readable_pipe[0], &order);
+
+    EXPECT_TRUE(reactor.run().has_value());
+    EXPECT_EQ(order, (std::vector<std::string>{"writable", "readable"}));
+
+    for (int fd : {readable_pipe[0], readable_pipe[1], writable_pipe[0], writable_pipe[1]}) {
+        (void)reactor.unregister_fd(fd);
+        close(fd);
+    }
+}
+#endif
@@ -1,8 +1,30 @@
 #include "katana/core/cpu_info.hpp"
 #include "katana/core/reactor_pool.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// reactor::stop() is lost on a thread that has not entered run() yet, so tests that stop as
+// soon as their condition holds first wait for every reactor to be running.
+void wait_until_running(katana::reactor_pool& pool) {
+    std::atomic<size_t> running{0};
+    for (auto& r : pool) {
+        r.schedule([&running]() { ++running; });
+    }
+    while (running.load() < pool.reactor_count()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
 
 TEST(ReactorPoolTest, CreatePool) {
     katana::reactor_pool_config config;
@@ -107,3 +129,368 @@ TEST(ReactorPoolTest, IsolatedState) {
     EXPECT_EQ(counter0.load(), 10);
     EXPECT_EQ(counter1.load(), 10);
 }
+
+TEST(ReactorPoolTest, OffloadRunsElsewhereAndResumesOnOwner) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    config.enable_work_stealing = true;
+
+    katana::reactor_pool pool(config);
+
+    std::atomic<bool> offloaded{false};
+    std::atomic<bool> resumed{false};
+    std::thread::id owner_thread;
+    std::thread::id work_thread;
+    std::thread::id resume_thread;
+    int value = 0;
+
+    pool.get_reactor(0).schedule([&]() {
+        owner_thread = std::this_thread::get_id();
+        offloaded = pool.offload(
+            [&]() {
+                work_thread = std::this_thread::get_id();
+                return 42;
+            },
+            [&](int result) {
+                resume_thread = std::this_thread::get_id();
+                value = result;
+                resumed.store(true, std::memory_order_release);
+            });
+    });
+
+    pool.start();
+    wait_until_running(pool);
+    for (int i = 0; i < 200 && !resumed.load(std::memory_order_acquire); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_TRUE(offloaded.load());
+    ASSERT_TRUE(resumed.load());
+    EXPECT_EQ(value, 42);
+    EXPECT_NE(work_thread, owner_thread);
+    EXPECT_EQ(resume_thread, owner_thread);
+    EXPECT_EQ(pool.offloaded_jobs(), 1);
+    EXPECT_EQ(pool.stolen_jobs(), 1);
+}
+
+TEST(ReactorPoolTest, OffloadResumesOnOwnerDuringGracefulStop) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    config.enable_work_stealing = true;
+    config.max_pending_tasks = 8;
+
+    katana::reactor_pool pool(config);
+
+    // An open fd on each reactor keeps its graceful drain going.
+    int pipes[2][2];
+    for (size_t i = 0; i < 2; ++i) {
+        ASSERT_EQ(pipe(pipes[i]), 0);
+        int fd = pipes[i][0];
+        pool.get_reactor(i).schedule([&pool, i, fd]() {
+            (void)pool.get_reactor(i).register_fd(
+                fd, katana::event_type::readable, [](katana::event_type) {});
+        });
+    }
+
+    std::atomic<bool> working{false};
+    std::atomic<bool> resumed{false};
+    pool.get_reactor(0).schedule([&]() {
+        pool.offload(
+            [&]() {
+                working.store(true, std::memory_order_release);
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            },
+            [&]() {
+                (void)pool.get_reactor(0).unregister_fd(pipes[0][0]);
+                close(pipes[0][0]);
+                resumed.store(true, std::memory_order_release);
+            });
+        // The owner's queue stays full while the job finishes, so the resume must be deferred.
+        while (pool.get_reactor(0).schedule([]() {})) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    });
+
+    pool.start();
+    while (!working.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.graceful_stop(std::chrono::milliseconds(500));
+    pool.wait();
+
+    EXPECT_TRUE(resumed.load());
+    close(pipes[0][1]);
+    close(pipes[1][1]);
+}
+
+TEST(ReactorPoolTest, OffloadRefusedOffReactorOrWhenDisabled) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    config.enable_work_stealing = true;
+
+    katana::reactor_pool pool(config);
+    EXPECT_FALSE(pool.current_reactor_index().has_value());
+    EXPECT_FALSE(pool.offload([]() {}, []() {}));
+
+    katana::reactor_pool_config plain_config;
+    plain_config.reactor_count = 1;
+    katana::reactor_pool plain(plain_config);
+
+    std::atomic<int> outcome{0};
+    plain.get_reactor(0).schedule([&]() {
+        outcome = plain.offload([]() {}, []() {}) ? 1 : 2;
+    });
+    plain.start();
+    for (int i = 0; i < 200 && outcome.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    plain.stop();
+    plain.wait();
+
+    EXPECT_EQ(outcome.load(), 2);
+}
+
+TEST(ReactorPoolTest, PostBatchRunsOnTargetWithOneWakeup) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    katana::reactor_pool pool(config);
+
+    constexpr int task_count = 100;
+    std::atomic<int> ran{0};
+    std::atomic<int> off_target{0};
+    std::atomic<size_t> taken{0};
+
+    pool.get_reactor(0).schedule([&]() {
+        std::vector<katana::task_fn> tasks;
+        for (int i = 0; i < task_count; ++i) {
+            tasks.emplace_back([&, i]() {
+                if (pool.current_reactor_index() != 1 || ran.load() != i) {
+                    ++off_target;
+                }
+                ++ran;
+            });
+        }
+        taken = pool.post_batch(1, tasks);
+    });
+    pool.start();
+    wait_until_running(pool);
+    for (int i = 0; i < 200 && ran.load() < task_count; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_EQ(taken.load(), static_cast<size_t>(task_count));
+    EXPECT_EQ(ran.load(), task_count);
+    EXPECT_EQ(off_target.load(), 0);
+    EXPECT_EQ(pool.posted_tasks(), static_cast<uint64_t>(task_count));
+    EXPECT_EQ(pool.post_wakeups(), 1);
+}
+
+TEST(ReactorPoolTest, PostFromOutsidePoolFallsBackToSchedule) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    katana::reactor_pool pool(config);
+
+    std::atomic<int> ran{0};
+    EXPECT_TRUE(pool.post(1, [&]() { ran = pool.current_reactor_index() == 1 ? 1 : 2; }));
+    pool.start();
+    wait_until_running(pool);
+    for (int i = 0; i < 200 && ran.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_EQ(ran.load(), 1);
+    EXPECT_EQ(pool.posted_tasks(), 0);
+}
+
+TEST(ReactorPoolTest, MigrationTargetFollowsLoadScores) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    config.enable_connection_migration = true;
+    config.migration_min_load_gap = 200;
+    config.migration_check_interval = 1;
+    katana::reactor_pool pool(config);
+
+    int fds[2][2];
+    ASSERT_EQ(pipe(fds[0]), 0);
+    ASSERT_EQ(pipe(fds[1]), 0);
+    for (auto& p : fds) {
+        ASSERT_TRUE(pool.get_reactor(0).register_fd(
+            p[0], katana::event_type::readable, [](katana::event_type) {}));
+    }
+    EXPECT_FALSE(pool.migration_target().has_value());
+
+    // Two fds against none clears the gap; the second call falls inside the check interval.
+    std::atomic<int> first{-1};
+    std::atomic<int> second{-1};
+    pool.start();
+    wait_until_running(pool);
+    pool.get_reactor(0).schedule([&]() {
+        first = static_cast<int>(pool.migration_target().value_or(99));
+        second = static_cast<int>(pool.migration_target().value_or(99));
+    });
+    for (int i = 0; i < 200 && second.load() == -1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_EQ(first.load(), 1);
+    EXPECT_EQ(second.load(), 99);
+    EXPECT_EQ(pool.migrated_connections(), 1);
+    for (auto& p : fds) {
+        (void)pool.get_reactor(0).unregister_fd(p[0]);
+        close(p[0]);
+        close(p[1]);
+    }
+}
+
+TEST(ReactorPoolTest, CpuSteeringAcceptsOnReactorOfConnectingCpu) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 2;
+    config.enable_cpu_steering = true;
+    katana::reactor_pool pool(config);
+
+    constexpr uint16_t port = 18391;
+    std::atomic<int> accepted[2] = {0, 0};
+    auto res = pool.start_accepting(port, [&](katana::reactor&, int32_t fd) {
+        ++accepted[*pool.current_reactor_index()];
+        close(fd);
+    });
+    ASSERT_TRUE(res);
+    pool.start();
+    wait_until_running(pool);
+
+    // Loopback SYNs are processed on the sending CPU, which is pinned to CPU 0.
+    constexpr int clients = 8;
+    std::thread client([&]() {
+        ASSERT_TRUE(katana::cpu_info::pin_thread_to_core(0));
+        for (int i = 0; i < clients; ++i) {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+            close(fd);
+        }
+    });
+    client.join();
+    for (int i = 0; i < 200 && accepted[0].load() + accepted[1].load() < clients; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_EQ(accepted[0].load(), clients);
+    EXPECT_EQ(accepted[1].load(), 0);
+}
+
+TEST(ReactorPoolTest, AcceptRecoversAfterDescriptorExhaustion) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 1;
+    katana::reactor_pool pool(config);
+
+    constexpr uint16_t port = 18392;
+    std::atomic<int> accepted{0};
+    auto res = pool.start_accepting(port, [&](katana::reactor&, int32_t fd) {
+        ++accepted;
+        close(fd);
+    });
+    ASSERT_TRUE(res);
+    pool.start();
+    wait_until_running(pool);
+
+    rlimit saved{};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &saved), 0);
+    rlimit lowered = saved;
+    lowered.rlim_cur = std::min<rlim_t>(saved.rlim_cur, 512);
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(client, 0);
+    std::vector<int> fillers;
+    for (int fd; (fd = dup(client)) >= 0;) {
+        fillers.push_back(fd);
+    }
+    EXPECT_EQ(errno, EMFILE);
+
+    // The handshake completes in the backlog; the reactor cannot take the connection yet.
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    EXPECT_EQ(connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(accepted.load(), 0);
+
+    for (int fd : fillers) {
+        close(fd);
+    }
+    for (int i = 0; i < 400 && accepted.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    close(client);
+    setrlimit(RLIMIT_NOFILE, &saved);
+    pool.stop();
+    pool.wait();
+
+    EXPECT_EQ(accepted.load(), 1);
+}
+
+TEST(ReactorPoolTest, ParsesSysfsCpuLists) {
+    using katana::cpu_info;
+    EXPECT_EQ(cpu_info::parse_cpu_list("0-3,8,10-11\n"),
+              (std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(cpu_info::parse_cpu_list("5"), (std::vector<uint32_t>{5}));
+    EXPECT_TRUE(cpu_info::parse_cpu_list("\n").empty());
+    EXPECT_EQ(cpu_info::parse_cpu_list("2,7-x"), (std::vector<uint32_t>{2}));
+
+    auto nodes = cpu_info::numa_nodes();
+    ASSERT_FALSE(nodes.empty());
+    for (const auto& node : nodes) {
+        EXPECT_FALSE(node.cpus.empty());
+    }
+}
+
+TEST(ReactorPoolTest, NumaPlacementUsesTopology) {
+    katana::reactor_pool_config config;
+    config.reactor_count = 3;
+    config.enable_numa_placement = true;
+    katana::reactor_pool pool(config);
+
+    auto nodes = katana::cpu_info::numa_nodes();
+    for (size_t i = 0; i < pool.reactor_count(); ++i) {
+        auto node = std::find_if(nodes.begin(), nodes.end(), [&](const katana::numa_node& n) {
+            return n.id == pool.reactor_node(i);
+        });
+        ASSERT_NE(node, nodes.end());
+        EXPECT_NE(std::find(node->cpus.begin(), node->cpus.end(), pool.reactor_cpu(i)),
+                  node->cpus.end());
+    }
+    // Round-robin over nodes: the first reactors land on distinct nodes.
+    if (nodes.size() > 1) {
+        EXPECT_NE(pool.reactor_node(0), pool.reactor_node(1));
+    }
+
+    std::atomic<bool> ran{false};
+    pool.get_reactor(0).schedule([&]() {
+        (void)pool.post(1, [&]() { ran = true; });
+    });
+    pool.start();
+    wait_until_running(pool);
+    for (int i = 0; i < 200 && !ran.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool.stop();
+    pool.wait();
+
+    EXPECT_TRUE(ran.load());
+    uint64_t expected = pool.reactor_node(0) != pool.reactor_node(1) ? 1 : 0;
+    EXPECT_EQ(pool.aggregate_metrics().cross_node_tasks, expected);
+}
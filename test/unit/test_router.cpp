@@ -29,6 +29,40 @@ handler_fn make_handler(std::string body) {
     };
 }
 
+std::vector<std::string>& pipeline_trace() {
+    static std::vector<std::string> trace;
+    return trace;
+}
+
+struct timing_layer {
+    template <typename Next>
+    result<response> operator()(const request&, request_context&, Next&& next) const {
+        pipeline_trace().push_back("wrap-before");
+        auto res = next();
+        pipeline_trace().push_back("wrap-after");
+        return res;
+    }
+};
+
+struct auth_layer {
+    std::optional<response> before(const request& req, request_context&) const {
+        pipeline_trace().push_back("auth");
+        if (req.uri == "/private") {
+            return response::error(problem_details::unauthorized());
+        }
+        return std::nullopt;
+    }
+};
+
+struct header_layer {
+    void after(const request&, request_context&, result<response>& res) const {
+        pipeline_trace().push_back("header");
+        if (res) {
+            res->set_header("X-Layer", "1");
+        }
+    }
+};
+
 } // namespace
 
 TEST(Router, PrefersStaticOverParams) {
@@ -144,6 +178,34 @@ TEST(Router, MiddlewareOrderAndShortCircuit) {
     EXPECT_EQ(trace, expected);
 }
 
+TEST(Router, CompiledMiddlewareRunsHooksInOrderAndShortCircuits) {
+    constexpr auto chain = make_middleware_chain<timing_layer, header_layer, auth_layer>();
+    route_entry routes[] = {
+        route_entry{method::get, path_pattern::from_literal<"/open">(), make_handler("ok"), chain},
+        route_entry{
+            method::get, path_pattern::from_literal<"/private">(), make_handler("secret"), chain},
+    };
+
+    router r(routes);
+    monotonic_arena arena;
+    request_context ctx{arena};
+
+    pipeline_trace().clear();
+    auto res = r.dispatch(make_request(method::get, "/open"), ctx);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "ok");
+    EXPECT_EQ(res->headers.get("X-Layer"), std::optional<std::string_view>("1"));
+    std::vector<std::string> expected{"wrap-before", "auth", "header", "wrap-after"};
+    EXPECT_EQ(pipeline_trace(), expected);
+
+    pipeline_trace().clear();
+    res = r.dispatch(make_request(method::get, "/private"), ctx);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 401);
+    EXPECT_EQ(res->headers.get("X-Layer"), std::optional<std::string_view>("1"));
+    EXPECT_EQ(pipeline_trace(), expected);
+}
+
 TEST(Router, CapturesMultipleParamsAndStripsQuery) {
     route_entry routes[] = {
         route_entry{method::get,
@@ -163,6 +225,49 @@ TEST(Router, CapturesMultipleParamsAndStripsQuery) {
     EXPECT_EQ(ctx.params.get("itemId"), std::optional<std::string_view>("99"));
 }
 
+TEST(Router, TypedParamsConvertWhileMatching) {
+    route_entry routes[] = {
+        route_entry{
+            method::get, path_pattern::from_literal<"/users/{name}">(), make_handler("name")},
+        route_entry{
+            method::get, path_pattern::from_literal<"/users/{id:int64}">(), make_handler("id")},
+        route_entry{
+            method::get, path_pattern::from_literal<"/files/{key:uuid}">(), make_handler("file")},
+    };
+
+    router r(routes);
+    monotonic_arena arena;
+    request_context ctx{arena};
+
+    // Declared order does not matter: the typed route wins whenever the segment converts.
+    auto res = r.dispatch(make_request(method::get, "/users/-42"), ctx);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "id");
+    EXPECT_EQ(ctx.params.int64_at(0), -42);
+    EXPECT_EQ(ctx.params.at(0), "-42");
+
+    res = r.dispatch(make_request(method::get, "/users/42x"), ctx);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "name");
+    EXPECT_EQ(ctx.params.get("name"), std::optional<std::string_view>("42x"));
+
+    route_cache cache;
+    for (int i = 0; i < 2; ++i) {
+        auto info = r.dispatch_with_info(
+            make_request(method::get, "/files/123E4567-e89b-12d3-a456-426614174000"), ctx, cache);
+        ASSERT_TRUE(info.route_response);
+        EXPECT_EQ(info.route_response->body, "file");
+        EXPECT_EQ(ctx.params.uuid_at(0).bytes[0], 0x12);
+        EXPECT_EQ(ctx.params.uuid_at(0).bytes[15], 0x00);
+    }
+    EXPECT_EQ(cache.hits(), 1u);
+
+    // A segment that does not convert matches nothing: 404, not a handler-level 400.
+    res = r.dispatch(make_request(method::get, "/files/123e4567-e89b-12d3-a456-42661417400z"), ctx);
+    ASSERT_FALSE(res);
+    EXPECT_EQ(res.error(), make_error_code(error_code::not_found));
+}
+
 TEST(Router, HarnessIntegrationAndProblemDetails) {
     route_entry routes[] = {
         route_entry{method::get,
@@ -185,3 +290,145 @@ TEST(Router, HarnessIntegrationAndProblemDetails) {
     auto nf_resp = harness.run_raw("GET /missing HTTP/1.1\r\nHost: test\r\n\r\n");
     EXPECT_EQ(nf_resp.status, 404);
 }
+
+TEST(Router, CompressedLiteralEdgesFallBackToParams) {
+    route_entry routes[] = {
+        route_entry{
+            method::get, path_pattern::from_literal<"/api/v1/users/list">(), make_handler("list")},
+        route_entry{method::get,
+                    path_pattern::from_literal<"/api/{version}/users/{id}">(),
+                    make_handler("user")},
+        route_entry{method::get, path_pattern::from_literal<"/">(), make_handler("root")},
+    };
+
+    router r(routes);
+    monotonic_arena arena;
+
+    auto body_of = [&](std::string_view uri) -> std::string {
+        request_context ctx{arena};
+        auto res = r.dispatch(make_request(method::get, uri), ctx);
+        return res ? res->body : "error";
+    };
+
+    EXPECT_EQ(body_of("/api/v1/users/list"), "list");
+    // Diverges inside the merged "v1/users/list" edge, so only the parameter route is left.
+    EXPECT_EQ(body_of("/api/v1/users/7"), "user");
+    EXPECT_EQ(body_of("/api/v2/users/list"), "user");
+    EXPECT_EQ(body_of("/api/v1/users"), "error");
+    EXPECT_EQ(body_of("/api/v1/users/list/extra"), "error");
+    EXPECT_EQ(body_of("/"), "root");
+
+    request_context ctx{arena};
+    ASSERT_TRUE(r.dispatch(make_request(method::get, "/api/v1/users/7"), ctx));
+    ASSERT_EQ(ctx.params.size(), 2);
+    EXPECT_EQ(ctx.params.get("version"), std::optional<std::string_view>("v1"));
+    EXPECT_EQ(ctx.params.get("id"), std::optional<std::string_view>("7"));
+}
+
+TEST(Router, EqualSpecificityKeepsTableOrderAcrossBranches) {
+    route_entry routes[] = {
+        route_entry{method::get, path_pattern::from_literal<"/{kind}/b">(), make_handler("first")},
+        route_entry{method::get, path_pattern::from_literal<"/a/{id}">(), make_handler("second")},
+        route_entry{method::post, path_pattern::from_literal<"/a/b">(), make_handler("post")},
+        route_entry{method::put, path_pattern::from_literal<"/{x}/{y}">(), make_handler("put")},
+    };
+
+    router r(routes);
+    monotonic_arena arena;
+
+    request_context get_ctx{arena};
+    auto get_res = r.dispatch(make_request(method::get, "/a/b"), get_ctx);
+    ASSERT_TRUE(get_res);
+    EXPECT_EQ(get_res->body, "first");
+
+    request_context del_ctx{arena};
+    auto info = r.dispatch_with_info(make_request(method::del, "/a/b"), del_ctx);
+    EXPECT_TRUE(info.path_matched);
+    EXPECT_EQ(allow_header_from_mask(info.allowed_methods_mask), "GET, POST, PUT");
+}
+
+TEST(Router, UsesPrecomputedLookupWhenGiven) {
+    route_entry routes[] = {
+        route_entry{method::get, path_pattern::from_literal<"/a/{id}">(), make_handler("a")},
+        route_entry{
+            method::get, path_pattern::from_literal<"/{kind}/{id}">(), make_handler("generic")},
+    };
+
+    // Stands in for a katana_gen lookup; picks the route the index would rank second.
+    route_lookup_fn lookup = [](std::span<const std::string_view>,
+                                method) noexcept -> route_index::lookup_result {
+        return route_index::lookup_result{1, method_bit(method::get), true};
+    };
+    router r(routes, lookup);
+    monotonic_arena arena;
+    request_context ctx{arena};
+
+    auto res = r.dispatch(make_request(method::get, "/a/7"), ctx);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "generic");
+    EXPECT_EQ(ctx.params.get("kind"), std::optional<std::string_view>("a"));
+    EXPECT_EQ(ctx.params.get("id"), std::optional<std::string_view>("7"));
+}
+
+TEST(Router, RouteCacheAnswersRepeatedPaths) {
+    route_entry routes[] = {
+        route_entry{method::get, path_pattern::from_literal<"/health">(), make_handler("health")},
+        route_entry{method::get,
+                    path_pattern::from_literal<"/users/{id}/posts/{post}">(),
+                    make_handler("post")},
+        route_entry{method::post, path_pattern::from_literal<"/users/{id}/posts/{post}">(),
+                    make_handler("create")},
+    };
+
+    router r(routes);
+    route_cache cache;
+    monotonic_arena arena;
+
+    for (int round = 0; round < 2; ++round) {
+        request_context ctx{arena};
+        auto res = r.dispatch_with_info(
+            make_request(method::get, "/users/7/posts/99?verbose=1"), ctx, cache);
+        ASSERT_TRUE(res.route_response);
+        EXPECT_EQ(res.route_response->body, "post");
+        EXPECT_EQ(allow_header_from_mask(res.allowed_methods_mask), "GET, POST");
+        ASSERT_EQ(ctx.params.size(), 2);
+        EXPECT_EQ(ctx.params.get("id"), std::optional<std::string_view>("7"));
+        EXPECT_EQ(ctx.params.get("post"), std::optional<std::string_view>("99"));
+    }
+    EXPECT_EQ(cache.misses(), 1u);
+    EXPECT_EQ(cache.hits(), 1u);
+
+    reactor_metrics metrics;
+    cache.publish_to(&metrics);
+
+    // Same path, other method: its own entry.
+    request_context post_ctx{arena};
+    auto created =
+        r.dispatch_with_info(make_request(method::post, "/users/7/posts/99"), post_ctx, cache);
+    ASSERT_TRUE(created.route_response);
+    EXPECT_EQ(created.route_response->body, "create");
+    EXPECT_EQ(cache.misses(), 2u);
+
+    // Failed lookups are not cached.
+    for (int round = 0; round < 2; ++round) {
+        request_context ctx{arena};
+        auto missing = r.dispatch_with_info(make_request(method::get, "/missing"), ctx, cache);
+        EXPECT_FALSE(missing.route_response);
+    }
+    EXPECT_EQ(cache.misses(), 4u);
+    EXPECT_EQ(metrics.snapshot().route_cache_misses, 3u);
+    EXPECT_EQ(metrics.snapshot().route_cache_hits, 0u);
+    cache.publish_to(nullptr);
+
+    // Another router on the same thread never sees this router's entries.
+    route_entry other_routes[] = {
+        route_entry{method::get, path_pattern::from_literal<"/health">(), make_handler("other")},
+    };
+    router other(other_routes);
+    request_context other_ctx{arena};
+    auto other_res =
+        other.dispatch_with_info(make_request(method::get, "/health"), other_ctx, cache);
+    ASSERT_TRUE(other_res.route_response);
+    EXPECT_EQ(other_res.route_response->body, "other");
+    EXPECT_EQ(cache.hits(), 1u);
+}
@@ -1,12 +1,15 @@
 #include "katana/core/tcp_socket.hpp"
 
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <gtest/gtest.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <string>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 using namespace katana;
 
@@ -255,3 +258,73 @@ TEST_F(TcpSocketTest, NativeHandle) {
     socket.close();
     EXPECT_EQ(socket.native_handle(), -1);
 }
+
+TEST_F(TcpSocketTest, WriteZerocopyFallsBackToCopy) {
+    // AF_UNIX sockets reject SO_ZEROCOPY, so the data goes through the copying path.
+    tcp_socket socket(fd1_);
+    fd1_ = -1;
+
+    const char* msg = "zerocopy";
+    auto written = socket.write_zerocopy(
+        std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(msg), strlen(msg)));
+    ASSERT_TRUE(written);
+    EXPECT_EQ(*written, strlen(msg));
+    EXPECT_EQ(socket.zerocopy_sends(), 0u);
+
+    auto completed = socket.reap_zerocopy();
+    ASSERT_TRUE(completed);
+    EXPECT_EQ(*completed, 0u);
+
+    char buf[16]{};
+    EXPECT_EQ(::read(fd2_, buf, sizeof(buf)), static_cast<ssize_t>(strlen(msg)));
+    EXPECT_EQ(std::string(buf), msg);
+}
+
+TEST(TcpSocketZerocopy, CompletionsReportedOnLoopback) {
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(::listen(listener, 1), 0);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    int server = ::accept(listener, nullptr, nullptr);
+    ASSERT_GE(server, 0);
+
+    tcp_socket socket(client);
+    std::vector<uint8_t> payload(64 * 1024, 'z');
+    auto written = socket.write_zerocopy(payload);
+    ASSERT_TRUE(written);
+
+    size_t received = 0;
+    std::vector<uint8_t> buf(payload.size());
+    while (received < *written) {
+        ssize_t n = ::read(server, buf.data(), buf.size());
+        ASSERT_GT(n, 0);
+        received += static_cast<size_t>(n);
+    }
+
+    // The notification is queued once the receiver has consumed the loopback skbs.
+    uint32_t completed = 0;
+    for (int i = 0; i < 100 && completed != socket.zerocopy_sends(); ++i) {
+        auto reaped = socket.reap_zerocopy();
+        ASSERT_TRUE(reaped);
+        completed = *reaped;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(completed, socket.zerocopy_sends());
+
+    // Loopback delivery copies the pages, so the socket stops pinning them.
+    const uint32_t sends = socket.zerocopy_sends();
+    written = socket.write_zerocopy(payload);
+    ASSERT_TRUE(written);
+    EXPECT_EQ(socket.zerocopy_sends(), sends);
+
+    ::close(server);
+    ::close(listener);
+}
@@ -1,7 +1,9 @@
 #include "katana/core/wheel_timer.hpp"
 
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <thread>
+#include <vector>
 
 using namespace katana;
 
@@ -74,3 +76,100 @@ TEST(WheelTimer, SimpleFlow) {
 
     EXPECT_EQ(counter, 1);
 }
+
+TEST(WheelTimer, FiresExactlyAtDeadlinesOnEveryLevel) {
+    const auto t0 = wheel_timer<>::clock::now();
+    wheel_timer<> timer(t0);
+
+    // One deadline per level, one past the wheel's span, plus one sharing a level-2 slot.
+    const std::vector<int64_t> deadlines_ms = {
+        5, 70, 4'100, 4'097, 300'000, 20'000'000, int64_t{30} * 24 * 3600 * 1000};
+    std::vector<int64_t> fired;
+    for (auto ms : deadlines_ms) {
+        timer.add_at(t0 + std::chrono::milliseconds(ms), [&fired, ms]() { fired.push_back(ms); });
+    }
+
+    auto in_order = deadlines_ms;
+    std::sort(in_order.begin(), in_order.end());
+    for (auto ms : in_order) {
+        auto before = fired.size();
+        timer.tick(t0 + std::chrono::milliseconds(ms - 1));
+        EXPECT_EQ(fired.size(), before);
+        timer.tick(t0 + std::chrono::milliseconds(ms));
+        ASSERT_EQ(fired.size(), before + 1);
+        EXPECT_EQ(fired.back(), ms);
+    }
+    EXPECT_EQ(timer.pending_count(), 0u);
+}
+
+TEST(WheelTimer, NextExpirationNeverOvershootsEarliestDeadline) {
+    const auto t0 = wheel_timer<>::clock::now();
+    wheel_timer<> timer(t0);
+    EXPECT_EQ(timer.time_until_next_expiration(t0), std::chrono::milliseconds::max());
+
+    timer.add_at(t0 + std::chrono::milliseconds(10'000), []() {});
+    auto now = t0;
+    int wakeups = 0;
+    while (timer.pending_count() > 0) {
+        auto wait = timer.time_until_next_expiration(now);
+        ASSERT_NE(wait, std::chrono::milliseconds::max());
+        EXPECT_LE(now + wait, t0 + std::chrono::milliseconds(10'000));
+        now += wait;
+        timer.tick(now);
+        ++wakeups;
+    }
+    // Woken for each level the timer moves down, not once per tick.
+    EXPECT_LE(wakeups, static_cast<int>(wheel_timer<>::LEVELS));
+    EXPECT_EQ(now, t0 + std::chrono::milliseconds(10'000));
+}
+
+TEST(WheelTimer, NextExpirationFollowsCancelsAndWrappedSlots) {
+    const auto t0 = wheel_timer<>::clock::now();
+    wheel_timer<> timer(t0);
+
+    // Moves now_ into the middle of a level-0 turn so later slots wrap past index 63.
+    timer.add_at(t0 + std::chrono::milliseconds(50), []() {});
+    timer.tick(t0 + std::chrono::milliseconds(50));
+
+    auto near = timer.add_at(t0 + std::chrono::milliseconds(60), []() {});
+    timer.add_at(t0 + std::chrono::milliseconds(100), []() {});
+    auto now = t0 + std::chrono::milliseconds(50);
+    EXPECT_EQ(timer.time_until_next_expiration(now), std::chrono::milliseconds(10));
+
+    // The emptied slot must stop counting; 100 ms sits in a wrapped level-0 slot.
+    EXPECT_TRUE(timer.cancel(near));
+    EXPECT_EQ(timer.time_until_next_expiration(now), std::chrono::milliseconds(50));
+
+    timer.tick(t0 + std::chrono::milliseconds(100));
+    EXPECT_EQ(timer.pending_count(), 0u);
+
+    // 4145 ms lands in the level-1 slot just behind the current one, almost a full turn
+    // ahead: the next event is that slot coming round at 4096 ms.
+    now = t0 + std::chrono::milliseconds(100);
+    timer.add_at(t0 + std::chrono::milliseconds(4145), []() {});
+    EXPECT_EQ(timer.time_until_next_expiration(now), std::chrono::milliseconds(3996));
+    timer.tick(t0 + std::chrono::milliseconds(4096));
+    EXPECT_EQ(timer.time_until_next_expiration(t0 + std::chrono::milliseconds(4096)),
+              std::chrono::milliseconds(49));
+}
+
+TEST(WheelTimer, CallbacksMayCancelAndRearm) {
+    const auto t0 = wheel_timer<>::clock::now();
+    wheel_timer<> timer(t0);
+
+    int rearmed = 0;
+    bool cancelled_ran = false;
+    wheel_timer<>::timeout_id victim = 0;
+    timer.add_at(t0 + std::chrono::milliseconds(3), [&]() {
+        EXPECT_TRUE(timer.cancel(victim));
+        timer.add_at(t0 + std::chrono::milliseconds(3), [&]() { ++rearmed; });
+    });
+    victim = timer.add_at(t0 + std::chrono::milliseconds(4), [&]() { cancelled_ran = true; });
+
+    timer.tick(t0 + std::chrono::milliseconds(3));
+    EXPECT_FALSE(cancelled_ran);
+    EXPECT_EQ(rearmed, 0);
+    timer.tick(t0 + std::chrono::milliseconds(4));
+    EXPECT_EQ(rearmed, 1);
+    EXPECT_FALSE(timer.cancel(victim));
+}
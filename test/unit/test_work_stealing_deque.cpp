@@ -0,0 +1,78 @@
+#include "katana/core/work_stealing_deque.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using katana::work_stealing_deque;
+
+TEST(WorkStealingDeque, OwnerPopsLifoThievesStealFifo) {
+    work_stealing_deque<int> deque(4);
+    for (int i = 1; i <= 3; ++i) {
+        deque.push(i);
+    }
+
+    EXPECT_EQ(deque.size(), 3);
+    EXPECT_EQ(deque.pop().value_or(0), 3);
+    EXPECT_EQ(deque.steal().value_or(0), 1);
+    EXPECT_EQ(deque.pop().value_or(0), 2);
+    EXPECT_FALSE(deque.pop().has_value());
+    EXPECT_FALSE(deque.steal().has_value());
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, GrowsPastInitialCapacity) {
+    work_stealing_deque<int> deque(2);
+    for (int i = 0; i < 1000; ++i) {
+        deque.push(i);
+    }
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(deque.steal().value_or(-1), i);
+    }
+    for (int i = 999; i >= 500; --i) {
+        EXPECT_EQ(deque.pop().value_or(-1), i);
+    }
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, EveryItemTakenExactlyOnceUnderContention) {
+    constexpr int ITEMS = 200000;
+    constexpr int THIEVES = 3;
+    work_stealing_deque<int> deque(64);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; ++t) {
+        thieves.emplace_back([&]() {
+            while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+                if (auto item = deque.steal()) {
+                    taken[static_cast<size_t>(*item)].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < ITEMS; ++i) {
+        deque.push(i);
+        if (i % 3 == 0) {
+            if (auto item = deque.pop()) {
+                taken[static_cast<size_t>(*item)].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    while (auto item = deque.pop()) {
+        taken[static_cast<size_t>(*item)].fetch_add(1, std::memory_order_relaxed);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    int wrong = 0;
+    for (auto& count : taken) {
+        wrong += count.load() == 1 ? 0 : 1;
+    }
+    EXPECT_EQ(wrong, 0);
+}
@@ -1,12 +1,381 @@
 #include "generator.hpp"
 
+#include "katana/core/router.hpp"
+
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <vector>
 
 namespace katana_gen {
+namespace {
+
+struct route_shape {
+    uint32_t index; // position in make_router's table
+    katana::http::method method;
+    std::vector<std::string_view> segments; // empty view for a parameter
+    std::vector<katana::http::param_type> types; // per segment; string for literals
+    int score;
+};
+
+struct dispatch_bucket {
+    std::string_view key; // empty for a fallback bucket
+    size_t segment_count;
+    std::vector<const route_shape*> routes;
+};
+
+// Calls f(segment, parameter name or empty) for each segment of a spec path.
+template <typename F> void for_each_path_segment(std::string_view path, F&& f) {
+    while (!path.empty()) {
+        auto slash = path.find('/');
+        auto segment = path.substr(0, slash);
+        path = slash == std::string_view::npos ? std::string_view{} : path.substr(slash + 1);
+        if (segment.empty()) {
+            continue;
+        }
+        const bool parameter = segment.front() == '{' && segment.back() == '}';
+        f(segment,
+          parameter && segment.size() > 2 ? segment.substr(1, segment.size() - 2)
+                                          : std::string_view{});
+    }
+}
+
+// Path parameters the router converts while matching: integers as int64 and uuid-format
+// strings as uuid. Everything else is matched and passed on as text.
+katana::http::param_type path_param_type(const katana::openapi::operation& op,
+                                         std::string_view name) {
+    for (const auto& param : op.parameters) {
+        if (param.in != katana::openapi::param_location::path || !param.type ||
+            std::string_view(param.name) != name) {
+            continue;
+        }
+        if (param.type->kind == katana::openapi::schema_kind::integer) {
+            return katana::http::param_type::int64;
+        }
+        if (param.type->kind == katana::openapi::schema_kind::string &&
+            std::string_view(param.type->format) == "uuid") {
+            return katana::http::param_type::uuid;
+        }
+    }
+    return katana::http::param_type::string;
+}
+
+// The operation's path with its parameter types declared: /users/{id} -> /users/{id:int64}.
+std::string typed_route_path(std::string_view path, const katana::openapi::operation& op) {
+    std::string out;
+    for_each_path_segment(path, [&](std::string_view segment, std::string_view name) {
+        out += '/';
+        if (name.empty()) {
+            out += segment;
+            return;
+        }
+        out += '{';
+        out += name;
+        switch (path_param_type(op, name)) {
+        case katana::http::param_type::int64:
+            out += ":int64";
+            break;
+        case katana::http::param_type::uuid:
+            out += ":uuid";
+            break;
+        case katana::http::param_type::string:
+            break;
+        }
+        out += '}';
+    });
+    return out.empty() ? "/" : out;
+}
+
+// Position of parameter `name` among the path's parameters, as in ctx.params; npos if absent.
+size_t path_param_index(std::string_view path, std::string_view name) {
+    size_t index = 0;
+    size_t found = std::string_view::npos;
+    for_each_path_segment(path, [&](std::string_view, std::string_view param) {
+        if (param.empty()) {
+            return;
+        }
+        if (param == name && found == std::string_view::npos) {
+            found = index;
+        }
+        ++index;
+    });
+    return found;
+}
+
+// Routes in make_router's order: operations with an operationId, in spec order.
+std::vector<route_shape> collect_route_shapes(const document& doc) {
+    std::vector<route_shape> shapes;
+    for (const auto& path : doc.paths) {
+        for (const auto& op : path.operations) {
+            if (op.operation_id.empty()) {
+                continue;
+            }
+            route_shape shape{static_cast<uint32_t>(shapes.size()), op.method, {}, {}, 0};
+            size_t literals = 0;
+            size_t typed = 0;
+            for_each_path_segment(path.path, [&](std::string_view segment, std::string_view name) {
+                const auto type =
+                    name.empty() ? katana::http::param_type::string : path_param_type(op, name);
+                shape.segments.push_back(name.empty() ? segment : std::string_view{});
+                shape.types.push_back(type);
+                literals += name.empty() ? 1 : 0;
+                typed += type != katana::http::param_type::string ? 1 : 0;
+            });
+            shape.score = katana::http::path_pattern::specificity_score(
+                literals, shape.segments.size() - literals, typed);
+            shapes.push_back(std::move(shape));
+        }
+    }
+    return shapes;
+}
+
+const char* param_type_literal(katana::http::param_type type) {
+    switch (type) {
+    case katana::http::param_type::int64:
+        return "int64";
+    case katana::http::param_type::uuid:
+        return "uuid";
+    case katana::http::param_type::string:
+        break;
+    }
+    return "string";
+}
+
+bool literal_at(const route_shape& shape, size_t position) {
+    return position < shape.segments.size() && !shape.segments[position].empty();
+}
+
+// Segment position whose literals split the routes into the most buckets; a shared prefix such
+// as /api/v1 would otherwise put every route in one.
+size_t choose_key_position(const std::vector<route_shape>& shapes) {
+    size_t best_position = 0;
+    size_t best_keys = 0;
+    for (size_t position = 0; position < katana::http::MAX_ROUTE_SEGMENTS; ++position) {
+        std::vector<std::pair<std::string_view, size_t>> keys;
+        for (const auto& shape : shapes) {
+            if (!literal_at(shape, position)) {
+                continue;
+            }
+            std::pair<std::string_view, size_t> key{shape.segments[position],
+                                                    shape.segments.size()};
+            if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+                keys.push_back(key);
+            }
+        }
+        if (keys.size() > best_keys) {
+            best_keys = keys.size();
+            best_position = position;
+        }
+    }
+    return best_position;
+}
+
+// Keyed buckets (literal at the key position, plus the routes of that length with a parameter
+// there) come first, then one fallback bucket per length for the parameter routes alone.
+// Candidates are in the order the runtime router would prefer them.
+std::vector<dispatch_bucket> build_buckets(const std::vector<route_shape>& shapes,
+                                           size_t key_position) {
+    std::vector<dispatch_bucket> buckets;
+    for (const auto& shape : shapes) {
+        if (!literal_at(shape, key_position)) {
+            continue;
+        }
+        auto key = shape.segments[key_position];
+        auto it = std::find_if(buckets.begin(), buckets.end(), [&](const dispatch_bucket& b) {
+            return b.key == key && b.segment_count == shape.segments.size();
+        });
+        if (it == buckets.end()) {
+            buckets.push_back(dispatch_bucket{key, shape.segments.size(), {}});
+            it = buckets.end() - 1;
+        }
+        it->routes.push_back(&shape);
+    }
+    const size_t keyed = buckets.size();
+
+    for (size_t count = 0; count <= katana::http::MAX_ROUTE_SEGMENTS; ++count) {
+        dispatch_bucket fallback{{}, count, {}};
+        for (const auto& shape : shapes) {
+            if (shape.segments.size() != count || literal_at(shape, key_position)) {
+                continue;
+            }
+            fallback.routes.push_back(&shape);
+            for (size_t i = 0; i < keyed; ++i) {
+                if (buckets[i].segment_count == count) {
+                    buckets[i].routes.push_back(&shape);
+                }
+            }
+        }
+        if (!fallback.routes.empty()) {
+            buckets.push_back(std::move(fallback));
+        }
+    }
+
+    for (auto& bucket : buckets) {
+        std::sort(bucket.routes.begin(),
+                  bucket.routes.end(),
+                  [](const route_shape* a, const route_shape* b) {
+                      return a->score != b->score ? a->score > b->score : a->index < b->index;
+                  });
+    }
+    return buckets;
+}
+
+struct perfect_hash {
+    uint32_t seed = 0;
+    std::vector<int32_t> slots; // bucket per slot, -1 when empty
+};
+
+perfect_hash find_perfect_hash(const std::vector<dispatch_bucket>& buckets) {
+    size_t keyed = 0;
+    while (keyed < buckets.size() && !buckets[keyed].key.empty()) {
+        ++keyed;
+    }
+    size_t table_size = std::bit_ceil(std::max<size_t>(8, keyed * 2));
+    for (;;) {
+        for (uint32_t seed = 0; seed < 4096; ++seed) {
+            perfect_hash hash{seed, std::vector<int32_t>(table_size, -1)};
+            bool collision = false;
+            for (size_t i = 0; i < keyed && !collision; ++i) {
+                auto slot = katana::http::route_key_hash(
+                                seed, buckets[i].key, buckets[i].segment_count) &
+                            (table_size - 1);
+                collision = hash.slots[slot] >= 0;
+                hash.slots[slot] = static_cast<int32_t>(i);
+            }
+            if (!collision) {
+                return hash;
+            }
+        }
+        table_size *= 2;
+    }
+}
+
+void generate_route_dispatch(std::ostringstream& out, const document& doc) {
+    const auto shapes = collect_route_shapes(doc);
+    const size_t key_position = choose_key_position(shapes);
+    const auto buckets = build_buckets(shapes, key_position);
+    const auto hash = find_perfect_hash(buckets);
+
+    size_t keyed = 0;
+    while (keyed < buckets.size() && !buckets[keyed].key.empty()) {
+        ++keyed;
+    }
+
+    out << "// Route lookup for make_router's table, fixed at generation time: a perfect hash on\n";
+    out << "// (segment " << key_position
+        << ", segment count) picks the one bucket a path can match, and its routes\n";
+    out << "// are checked in the order katana::http::router prefers them.\n";
+    out << "namespace route_dispatch {\n";
+    out << "inline constexpr size_t key_position = " << key_position << ";\n";
+    out << "inline constexpr uint32_t hash_seed = " << hash.seed << ";\n";
+    out << "inline constexpr size_t hash_mask = " << hash.slots.size() - 1 << ";\n";
+    out << "inline constexpr std::array<int32_t, " << hash.slots.size() << "> slot_bucket = {";
+    for (size_t i = 0; i < hash.slots.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << hash.slots[i] << ",";
+    }
+    out << "\n};\n";
+    out << "inline constexpr std::array<std::string_view, " << keyed << "> bucket_key = {\n";
+    for (size_t i = 0; i < keyed; ++i) {
+        out << "    \"" << escape_cpp_string(buckets[i].key) << "\",\n";
+    }
+    out << "};\n";
+    out << "inline constexpr std::array<uint8_t, " << keyed << "> bucket_segments = {";
+    for (size_t i = 0; i < keyed; ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << buckets[i].segment_count << ",";
+    }
+    out << "\n};\n";
+    out << "// Bucket for paths with no keyed literal, by segment count; -1 when none.\n";
+    out << "inline constexpr std::array<int32_t, katana::http::MAX_ROUTE_SEGMENTS + 1> "
+           "fallback_bucket = {";
+    for (size_t count = 0; count <= katana::http::MAX_ROUTE_SEGMENTS; ++count) {
+        int32_t bucket = -1;
+        for (size_t i = keyed; i < buckets.size(); ++i) {
+            if (buckets[i].segment_count == count) {
+                bucket = static_cast<int32_t>(i);
+            }
+        }
+        out << (count % 16 == 0 ? "\n    " : " ") << bucket << ",";
+    }
+    out << "\n};\n";
+    out << "} // namespace route_dispatch\n\n";
+
+    out << "inline katana::http::route_index::lookup_result\n";
+    out << "find_route(std::span<const std::string_view> segments, katana::http::method m) "
+           "noexcept {\n";
+    out << "    katana::http::route_index::lookup_result out;\n";
+    out << "    [[maybe_unused]] auto hit = [&](uint32_t route, katana::http::method route_method) "
+           "{\n";
+    out << "        out.path_matched = true;\n";
+    out << "        out.allowed_methods_mask |= katana::http::method_bit(route_method);\n";
+    out << "        if (route_method == m && out.route == "
+           "katana::http::route_index::NO_ROUTE) {\n";
+    out << "            out.route = route;\n";
+    out << "        }\n";
+    out << "    };\n\n";
+    out << "    const size_t count = segments.size();\n";
+    out << "    if (count > katana::http::MAX_ROUTE_SEGMENTS) {\n";
+    out << "        return out;\n";
+    out << "    }\n";
+    out << "    int32_t bucket = route_dispatch::fallback_bucket[count];\n";
+    out << "    if (count > route_dispatch::key_position) {\n";
+    out << "        const auto& key = segments[route_dispatch::key_position];\n";
+    out << "        const auto slot =\n";
+    out << "            katana::http::route_key_hash(route_dispatch::hash_seed, key, count) &\n";
+    out << "            route_dispatch::hash_mask;\n";
+    out << "        const int32_t keyed = route_dispatch::slot_bucket[slot];\n";
+    out << "        if (keyed >= 0) {\n";
+    out << "            const auto index = static_cast<size_t>(keyed);\n";
+    out << "            if (route_dispatch::bucket_segments[index] == count &&\n";
+    out << "                route_dispatch::bucket_key[index] == key) {\n";
+    out << "                bucket = keyed;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "    }\n\n";
+    out << "    switch (bucket) {\n";
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        out << "    case " << i << ":\n";
+        for (const auto* route : buckets[i].routes) {
+            std::string condition;
+            for (size_t s = 0; s < route->segments.size(); ++s) {
+                const auto segment = "segments[" + std::to_string(s) + "]";
+                std::string check;
+                if (!route->segments[s].empty()) {
+                    if (i < keyed && s == key_position) {
+                        continue;
+                    }
+                    check = segment + " == \"" + escape_cpp_string(route->segments[s]) + "\"";
+                } else if (route->types[s] != katana::http::param_type::string) {
+                    check = std::string("katana::http::valid_path_param(") +
+                            "katana::http::param_type::" + param_type_literal(route->types[s]) +
+                            ", " + segment + ")";
+                } else {
+                    continue;
+                }
+                if (!condition.empty()) {
+                    condition += " && ";
+                }
+                condition += check;
+            }
+            out << "        ";
+            if (!condition.empty()) {
+                out << "if (" << condition << ") ";
+            }
+            out << "hit(" << route->index << ", katana::http::method::"
+                << method_enum_literal(route->method) << ");\n";
+        }
+        out << "        break;\n";
+    }
+    out << "    default:\n";
+    out << "        break;\n";
+    out << "    }\n";
+    out << "    return out;\n";
+    out << "}\n\n";
+}
+
+} // namespace
 
 std::string generate_router_table(const document& doc) {
     std::ostringstream out;
@@ -14,6 +383,7 @@ std::string generate_router_table(const document& doc) {
     out << "#include \"katana/core/http.hpp\"\n";
     out << "#include \"katana/core/router.hpp\"\n";
     out << "#include <array>\n";
+    out << "#include <cstdint>\n";
     out << "#include <span>\n";
     out << "#include <string_view>\n\n";
     out << "namespace generated {\n\n";
@@ -156,6 +526,8 @@ std::string generate_router_table(const document& doc) {
 
     out << "} // namespace route_metadata\n\n";
 
+    generate_route_dispatch(out, doc);
+
     // Add compile-time validation
     out << "// Compile-time validations\n";
     out << "static_assert(route_count > 0, \"At least one route must be defined\");\n";
@@ -368,8 +740,8 @@ std::string generate_router_bindings(const document& doc) {
             }
             out << "        route_entry{katana::http::method::" << method_enum_literal(op.method)
                 << ",\n";
-            out << "                   katana::http::path_pattern::from_literal<\"" << path.path
-                << "\">(),\n";
+            out << "                   katana::http::path_pattern::from_literal<\""
+                << typed_route_path(path.path, op) << "\">(),\n";
             out << "                   handler_fn([&handler](const katana::http::request& req, "
                    "katana::http::request_context& ctx) -> katana::result<katana::http::response> "
                    "{\n";
@@ -391,14 +763,26 @@ std::string generate_router_bindings(const document& doc) {
                     continue;
                 }
                 auto param_ident = sanitize_identifier(param.name);
-                out << "                       auto p_" << param_ident << " = ctx.params.get(\""
-                    << param.name << "\");\n";
-                out << "                       if (!p_" << param_ident
-                    << ") return "
-                       "katana::http::response::error(katana::problem_details::bad_request("
-                       "\"missing "
-                       "path param "
-                    << param.name << "\"));\n";
+                // Parameters in the path were matched, and typed ones converted, by the router.
+                const size_t index = path_param_index(path.path, param.name);
+                if (index != std::string_view::npos) {
+                    if (path_param_type(op, param.name) == katana::http::param_type::int64) {
+                        out << "                       int64_t " << param_ident
+                            << " = ctx.params.int64_at(" << index << ");\n";
+                        continue;
+                    }
+                    out << "                       std::optional<std::string_view> p_"
+                        << param_ident << " = ctx.params.at(" << index << ");\n";
+                } else {
+                    out << "                       auto p_" << param_ident
+                        << " = ctx.params.get(\"" << param.name << "\");\n";
+                    out << "                       if (!p_" << param_ident
+                        << ") return "
+                           "katana::http::response::error(katana::problem_details::bad_request("
+                           "\"missing "
+                           "path param "
+                        << param.name << "\"));\n";
+                }
                 switch (param.type->kind) {
                 case katana::openapi::schema_kind::integer:
                     out << "                       int64_t " << param_ident << " = 0;\n";
@@ -713,7 +1097,7 @@ std::string generate_router_bindings(const document& doc) {
     }
 
     out << "    };\n";
-    out << "    static katana::http::router router_instance(route_entries);\n";
+    out << "    static katana::http::router router_instance(route_entries, &find_route);\n";
     out << "    return router_instance;\n";
     out << "}\n\n";
 